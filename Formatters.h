@@ -2,19 +2,54 @@
 #ifndef FORMATTERS_20160922_H_
 #define FORMATTERS_20160922_H_
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstdio>
 #include <cstring>
 #include <iterator>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef CXX11_PRINTF_INSTRUMENT
+#include "Instrument.h"
+#endif
 
 namespace cxx11 {
 
+// NOTE(eteran): contexts may optionally provide reserve(n) and commit(n). reserve
+//               returns a pointer to at least n chars of the destination which the
+//               caller may write directly, or nullptr if that isn't possible, in
+//               which case the caller falls back to write. commit(n) then accounts
+//               for the first n of those chars
+
+// NOTE(eteran): the basic_ contexts write any character type, much like
+//               std::basic_string. The char versions have the usual names
+
 // This context writes to a buffer
-struct buffer_writer  {
+template <class CharT>
+struct basic_buffer_writer  {
+	typedef CharT char_type;
 
-	buffer_writer(char *buffer, size_t size) : ptr_(buffer), size_(size) {
+	basic_buffer_writer(CharT *buffer, size_t size) : ptr_(buffer), size_(size) {
+#ifdef CXX11_PRINTF_INSTRUMENT
+		begin_ = buffer;
+#endif
 	}
 
-	void write(char ch) noexcept {
+	void write(CharT ch) noexcept {
 		if(size_ > 1) {
 			*ptr_++ = ch;
 			--size_;
@@ -22,36 +57,100 @@ struct buffer_writer  {
 		++written;
 	}
 	
-	void write(const char *p, size_t n) {
-		size_t count = std::min(size_, n);
-		memcpy(ptr_, p, count);
+	void write(const CharT *p, size_t n) {
+		// NOTE(eteran): always leave room for the NUL terminator
+		size_t count = (size_ > 1) ? std::min(size_ - 1, n) : 0;
+		memcpy(ptr_, p, count * sizeof(CharT));
+		ptr_    += count;
 		size_   -= count;
-		written += count;
+		written += n;
+	}
+
+	CharT *reserve(size_t n) noexcept {
+		// NOTE(eteran): output which would be truncated takes the slow path
+		return (size_ > n) ? ptr_ : nullptr;
+	}
+
+	void commit(size_t n) noexcept {
+		ptr_    += n;
+		size_   -= n;
+		written += n;
 	}
 
 	void done() noexcept {
 		if(size_ != 0) {
-			*ptr_ = '\0';
+			*ptr_ = CharT();
+		}
+#ifdef CXX11_PRINTF_INSTRUMENT
+		if(written != static_cast<size_t>(ptr_ - begin_)) {
+			instrument::record_truncation();
 		}
+#endif
 	}
 
-	char  *ptr_;
+	CharT *ptr_;
 	size_t size_;
 	size_t written = 0;
+#ifdef CXX11_PRINTF_INSTRUMENT
+	CharT *begin_;
+#endif
 };
 
-// This context writes to a container using a std::back_inserter
-struct ostream_writer {
+typedef basic_buffer_writer<char> buffer_writer;
+
+// This context writes to a buffer which is known to be large enough, such as
+// one sized using format_bound, so it does no bounds checking at all
+template <class CharT>
+struct basic_unchecked_writer {
+	typedef CharT char_type;
 
-	ostream_writer(std::ostream &os) : os_(os) {
+	basic_unchecked_writer(CharT *buffer) : ptr_(buffer) {
 	}
 
-	void write(char ch) {
+	void write(CharT ch) noexcept {
+		*ptr_++ = ch;
+		++written;
+	}
+
+	void write(const CharT *p, size_t n) noexcept {
+		memcpy(ptr_, p, n * sizeof(CharT));
+		ptr_    += n;
+		written += n;
+	}
+
+	CharT *reserve(size_t) noexcept {
+		return ptr_;
+	}
+
+	void commit(size_t n) noexcept {
+		ptr_    += n;
+		written += n;
+	}
+
+	void done() noexcept {
+		*ptr_ = CharT();
+	}
+
+	CharT *ptr_;
+	size_t written = 0;
+};
+
+typedef basic_unchecked_writer<char> unchecked_writer;
+
+// This context writes to a std::basic_ostream
+template <class CharT>
+struct basic_ostream_writer {
+	typedef CharT char_type;
+
+	basic_ostream_writer(std::basic_ostream<CharT> &os) : os_(os) {
+	}
+
+	void write(CharT ch) {
 		os_.put(ch);
 		++written;
 	}
 	
-	void write(const char *p, size_t n) {
+	void write(const CharT *p, size_t n) {
 		while(n--) {
 			write(*p++);
 		}
@@ -59,23 +158,69 @@ struct ostream_writer {
 	
 	void done() noexcept {}
 
-	std::ostream &os_;
+	std::basic_ostream<CharT> &os_;
 	size_t written = 0;
 };
 
-// This context writes to a container using a std::back_inserter
+typedef basic_ostream_writer<char> ostream_writer;
+
+#ifdef CXX11_PRINTF_HAS_CONSTEXPR
+// This context writes to a std::array, and can be used in constant expressions
+// (see cxx11::format_array). Output which doesn't fit is truncated at runtime,
+// and is an error at compile time
+template <class CharT, size_t N>
+struct basic_array_writer {
+	static_assert(N != 0, "cannot format into an empty array");
+
+	typedef CharT char_type;
+
+	constexpr void write(CharT ch) noexcept {
+		if(written < N - 1) {
+			buffer[written] = ch;
+		} else {
+			capacity_exceeded();
+		}
+		++written;
+	}
+
+	constexpr void write(const CharT *p, size_t n) noexcept {
+		while(n--) {
+			write(*p++);
+		}
+	}
+
+	constexpr void done() noexcept {
+		buffer[(written < N - 1) ? written : N - 1] = CharT();
+	}
+
+	// NOTE(eteran): deliberately not constexpr
+	static void capacity_exceeded() noexcept {}
+
+	std::array<CharT, N> buffer = {};
+	size_t written              = 0;
+};
+
+template <size_t N>
+using array_writer = basic_array_writer<char, N>;
+#endif
+
+// This context writes to a container using a std::back_inserter. Containers of
+// char16_t, char32_t or wchar_t are written as that type, anything else, such
+// as std::vector<uint8_t> or std::vector<int>, is written as char
 template <class C>
 struct container_writer {
+	typedef typename C::value_type value_type;
+	typedef typename std::conditional<std::is_same<value_type, char16_t>::value || std::is_same<value_type, char32_t>::value || std::is_same<value_type, wchar_t>::value, value_type, char>::type char_type;
 
 	container_writer(C &s) : it_(std::back_inserter(s)) {
 	}
 
-	void write(char ch) {
+	void write(char_type ch) {
 		*it_++ = ch;
 		++written;
 	}
 	
-	void write(const char *p, size_t n) {
+	void write(const char_type *p, size_t n) {
 		while(n--) {
 			write(*p++);
 		}
@@ -129,6 +274,473 @@ struct stdout_writer {
 	size_t written = 0;
 };
 
+
+// this context formats into a buffer owned by the calling thread, and emits the
+// whole result with a single fwrite (or write(2)) when done, so the output of
+// concurrent calls never interleaves mid-line. Unlike stdio_writer, the stream's
+// lock is only taken once per call
+class atomic_writer {
+public:
+	explicit atomic_writer(FILE *stream) : stream_(stream) {
+		acquire();
+	}
+
+#ifdef __linux__
+	// NOTE(eteran): POSIX only promises that a write(2) of at most PIPE_BUF bytes
+	//               to a pipe is not interleaved with other writers, and that with
+	//               O_APPEND each write(2) starts at the end of the file. done()
+	//               retries a partial write, and other output may come in between
+	explicit atomic_writer(int fd) : fd_(fd) {
+		acquire();
+	}
+#endif
+
+	~atomic_writer() {
+		if(buffer_ == &shared().buffer) {
+			shared().busy = false;
+		}
+	}
+
+	atomic_writer(const atomic_writer &) = delete;
+	atomic_writer &operator=(const atomic_writer &) = delete;
+
+public:
+	void write(char ch) {
+		if(ptr_ == end_) {
+			grow(1);
+		}
+		*ptr_++ = ch;
+		++written;
+	}
+
+	void write(const char *p, size_t n) {
+		if(static_cast<size_t>(end_ - ptr_) < n) {
+			grow(n);
+		}
+		memcpy(ptr_, p, n);
+		ptr_    += n;
+		written += n;
+	}
+
+	char *reserve(size_t n) {
+		if(static_cast<size_t>(end_ - ptr_) < n) {
+			grow(n);
+		}
+		return ptr_;
+	}
+
+	void commit(size_t n) noexcept {
+		ptr_    += n;
+		written += n;
+	}
+
+	void done() noexcept {
+		const char *p = &(*buffer_)[0];
+		size_t n      = ptr_ - p;
+
+#ifdef __linux__
+		if(fd_ != -1) {
+			while(n != 0) {
+				const ssize_t r = ::write(fd_, p, n);
+				if(r == -1) {
+					if(errno == EINTR) {
+						continue;
+					}
+					break;
+				}
+				p += r;
+				n -= r;
+			}
+		} else
+#endif
+		{
+			fwrite(p, 1, n, stream_);
+		}
+
+		ptr_ = &(*buffer_)[0];
+	}
+
+private:
+	struct thread_buffer {
+		std::string buffer;
+		bool        busy = false;
+	};
+
+	static thread_buffer &shared() {
+		static thread_local thread_buffer b;
+		return b;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: acquire
+	// Desc: uses the thread's buffer, unless it is already in use by an enclosing
+	//       call (such as from a to_string used by %?), in which case this writer
+	//       uses its own
+	//------------------------------------------------------------------------------
+	void acquire() {
+		thread_buffer &b = shared();
+		if(!b.busy) {
+			b.busy  = true;
+			buffer_ = &b.buffer;
+		} else {
+			buffer_ = &own_;
+		}
+
+		if(buffer_->empty()) {
+			buffer_->resize(initial_size);
+		}
+
+		ptr_ = &(*buffer_)[0];
+		end_ = ptr_ + buffer_->size();
+	}
+
+	void grow(size_t n) {
+		const size_t used = ptr_ - &(*buffer_)[0];
+		buffer_->resize(std::max(buffer_->size() * 2, used + n));
+		ptr_ = &(*buffer_)[0] + used;
+		end_ = &(*buffer_)[0] + buffer_->size();
+	}
+
+public:
+	size_t written = 0;
+
+private:
+	static constexpr size_t initial_size = 256;
+
+	FILE        *stream_ = nullptr;
+	int          fd_     = -1;
+	std::string *buffer_;
+	std::string  own_;
+	char        *ptr_;
+	char        *end_;
+};
+
+// a monotonic arena for request scoped strings, see arena_writer. Memory is
+// only ever released all at once, by reset() or on destruction
+class arena {
+	friend class arena_writer;
+
+public:
+	static constexpr size_t default_block_size = 4096;
+
+public:
+	explicit arena(size_t block_size = default_block_size) : block_size_(block_size) {
+	}
+
+	// NOTE(eteran): the initial buffer is used first, and is not owned
+	arena(char *buffer, size_t size, size_t block_size = default_block_size) : block_size_(block_size), buffer_(buffer), buffer_size_(size) {
+		reset();
+	}
+
+	~arena() {
+		release(nullptr);
+	}
+
+	arena(const arena &) = delete;
+	arena &operator=(const arena &) = delete;
+
+public:
+	//------------------------------------------------------------------------------
+	// Name: reset
+	// Desc: invalidates every string formatted into the arena. The most recent
+	//       (and therefore largest) block is kept for reuse, so a loop which
+	//       resets the arena per request soon stops allocating altogether
+	//------------------------------------------------------------------------------
+	void reset() noexcept {
+		if(blocks_) {
+			release(blocks_);
+			ptr_ = data(blocks_);
+			end_ = ptr_ + blocks_->size;
+		} else {
+			ptr_ = buffer_;
+			end_ = buffer_ + buffer_size_;
+		}
+	}
+
+private:
+	struct block {
+		block *prev;
+		size_t size;
+	};
+
+	static char *data(block *b) noexcept {
+		return reinterpret_cast<char *>(b + 1);
+	}
+
+	// frees every block older than keep
+	void release(block *keep) noexcept {
+		block *b = keep ? keep->prev : blocks_;
+		while(b) {
+			block *prev = b->prev;
+			::operator delete(b);
+			b = prev;
+		}
+
+		if(keep) {
+			keep->prev = nullptr;
+		}
+		blocks_ = keep;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: grow
+	// Desc: moves the string being formatted, the last used chars of the current
+	//       block, to a new block with room for at least n more chars. Returns
+	//       its new start
+	//------------------------------------------------------------------------------
+	char *grow(size_t used, size_t n) {
+		size_t size = std::max(block_size_, used + n);
+		if(blocks_) {
+			size = std::max(size, blocks_->size * 2);
+		}
+
+		block *b = static_cast<block *>(::operator new(sizeof(block) + size));
+		b->prev  = blocks_;
+		b->size  = size;
+		blocks_  = b;
+
+		if(used != 0) {
+			memcpy(data(b), ptr_, used);
+		}
+		ptr_ = data(b);
+		end_ = ptr_ + size;
+		return ptr_;
+	}
+
+private:
+	size_t block_size_;
+	char  *buffer_      = nullptr;
+	size_t buffer_size_ = 0;
+	block *blocks_      = nullptr;
+	char  *ptr_         = nullptr;
+	char  *end_         = nullptr;
+};
+
+// this context formats a NUL terminated string directly into the free space of
+// an arena, with no per string allocation. The string stays valid until the
+// arena is reset. Only one arena_writer may be in use on an arena at a time
+class arena_writer {
+public:
+	explicit arena_writer(arena &a) noexcept : arena_(a), begin_(a.ptr_), ptr_(a.ptr_), end_(a.end_) {
+	}
+
+	arena_writer(const arena_writer &) = delete;
+	arena_writer &operator=(const arena_writer &) = delete;
+
+public:
+	void write(char ch) {
+		if(ptr_ == end_) {
+			grow(1);
+		}
+		*ptr_++ = ch;
+		++written;
+	}
+
+	void write(const char *p, size_t n) {
+		// NOTE(eteran): <= since the NUL terminator must fit too
+		if(static_cast<size_t>(end_ - ptr_) <= n) {
+			grow(n);
+		}
+		memcpy(ptr_, p, n);
+		ptr_    += n;
+		written += n;
+	}
+
+	char *reserve(size_t n) {
+		if(static_cast<size_t>(end_ - ptr_) <= n) {
+			grow(n);
+		}
+		return ptr_;
+	}
+
+	void commit(size_t n) noexcept {
+		ptr_    += n;
+		written += n;
+	}
+
+	void done() {
+		if(ptr_ == end_) {
+			grow(1);
+		}
+		*ptr_ = '\0';
+		arena_.ptr_ = ptr_ + 1;
+	}
+
+	const char *c_str() const noexcept {
+		return begin_;
+	}
+
+	size_t size() const noexcept {
+		return ptr_ - begin_;
+	}
+
+#ifdef __cpp_lib_string_view
+	std::string_view view() const noexcept {
+		return std::string_view(begin_, ptr_ - begin_);
+	}
+#endif
+
+private:
+	void grow(size_t n) {
+		// NOTE(eteran): one extra for the NUL terminator
+		const size_t used = ptr_ - begin_;
+		arena_.ptr_ = begin_;
+		begin_      = arena_.grow(used, n + 1);
+		ptr_        = begin_ + used;
+		end_        = arena_.end_;
+	}
+
+public:
+	size_t written = 0;
+
+private:
+	arena &arena_;
+	char  *begin_;
+	char  *ptr_;
+	char  *end_;
+};
+
+#ifdef __linux__
+// this context writes to a file through a growable memory mapping. It is meant
+// to be reused for many calls, so like fprintf, written (and therefore the value
+// returned by Printf and stored by %n) counts the bytes written by each call
+class mmap_writer {
+public:
+	static constexpr size_t default_step = 64 * 1024 * 1024;
+
+public:
+	explicit mmap_writer(const char *path, size_t step = default_step) : step_(std::max<size_t>(step, sysconf(_SC_PAGESIZE))) {
+		fd_ = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if(fd_ == -1) {
+			sys_error = errno;
+		}
+	}
+
+	~mmap_writer() {
+		close();
+	}
+
+	mmap_writer(const mmap_writer &) = delete;
+	mmap_writer &operator=(const mmap_writer &) = delete;
+
+public:
+	void write(char ch) noexcept {
+		if(pos_ != capacity_ || grow(1)) {
+			map_[pos_++] = ch;
+		}
+		++written;
+	}
+
+	void write(const char *p, size_t n) noexcept {
+		if(capacity_ - pos_ >= n || grow(n)) {
+			memcpy(map_ + pos_, p, n);
+			pos_ += n;
+		}
+		written += n;
+	}
+
+	char *reserve(size_t n) noexcept {
+		if(capacity_ - pos_ >= n || grow(n)) {
+			return map_ + pos_;
+		}
+		return nullptr;
+	}
+
+	void commit(size_t n) noexcept {
+		pos_    += n;
+		written += n;
+	}
+
+	// NOTE(eteran): done() is called at the end of every Printf call, so it must
+	//               stay cheap. The file is trimmed to its final size by close()
+	void done() noexcept {}
+
+	// NOTE(eteran): called at the start of every Printf call
+	void start() noexcept {
+		total_  += written;
+		written  = 0;
+	}
+
+	// the number of bytes written over all calls
+	size_t size() const noexcept {
+		return total_ + written;
+	}
+
+	//------------------------------------------------------------------------------
+	// Name: close
+	// Desc: unmaps the file and trims it to the number of bytes actually written,
+	//       returns false if any error occurred since the file was opened
+	//------------------------------------------------------------------------------
+	bool close() noexcept {
+		if(fd_ == -1) {
+			return sys_error == 0;
+		}
+
+		if(map_) {
+			munmap(map_, capacity_);
+			map_ = nullptr;
+		}
+
+		if(ftruncate(fd_, static_cast<off_t>(pos_)) == -1 && sys_error == 0) {
+			sys_error = errno;
+		}
+
+		::close(fd_);
+		fd_       = -1;
+		capacity_ = 0;
+		return sys_error == 0;
+	}
+
+private:
+	//------------------------------------------------------------------------------
+	// Name: grow
+	// Desc: extends the file and the mapping by whole steps so that at least n more
+	//       bytes fit. On failure, the output is dropped and sys_error is set
+	//------------------------------------------------------------------------------
+	bool grow(size_t n) noexcept {
+		if(fd_ == -1 || sys_error != 0) {
+			return false;
+		}
+
+		const size_t needed   = pos_ + n;
+		const size_t capacity = ((needed + step_ - 1) / step_) * step_;
+
+		if(ftruncate(fd_, static_cast<off_t>(capacity)) == -1) {
+			sys_error = errno;
+			return false;
+		}
+
+		void *map = map_ ? mremap(map_, capacity_, capacity, MREMAP_MAYMOVE)
+		                 : mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+
+		if(map == MAP_FAILED) {
+			sys_error = errno;
+			return false;
+		}
+
+		// NOTE(eteran): output is strictly sequential, so let the kernel read ahead
+		//               and write back aggressively
+		madvise(map, capacity, MADV_SEQUENTIAL);
+
+		map_      = static_cast<char *>(map);
+		capacity_ = capacity;
+		return true;
+	}
+
+public:
+	int    sys_error = 0; // the errno of the first failed system call, if any
+	size_t written   = 0;
+
+private:
+	char  *map_      = nullptr;
+	size_t pos_      = 0;
+	size_t capacity_ = 0;
+	size_t total_    = 0; // written by the calls before this one
+	size_t step_;
+	int    fd_       = -1;
+};
+#endif
+
 }
 
 #endif
@@ -0,0 +1,331 @@
+
+#ifndef INSTRUMENT_20160922_H_
+#define INSTRUMENT_20160922_H_
+
+// NOTE(eteran): this header is only used when CXX11_PRINTF_INSTRUMENT is defined
+//               before including Printf.h. When it is not defined, none of the
+//               probes exist and the formatting code is exactly as it would be
+//               without instrumentation
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace cxx11 {
+namespace instrument {
+
+// a merged, plain copy of the counters of every thread
+struct stats {
+	uint64_t calls[256]     = {}; // conversions performed, indexed by conversion char
+	uint64_t bytes[256]     = {}; // bytes produced by conversions, indexed by conversion char
+	uint64_t latency[64]    = {}; // Printf calls, bucketed by floor(log2(cycles))
+	uint64_t printf_calls   = 0;
+	uint64_t truncations    = 0;  // buffer_writer calls which did not fit the buffer
+	uint64_t allocations    = 0;  // heap allocated strings produced by %?
+};
+
+namespace detail {
+
+// NOTE(eteran): each counter is only ever modified by its owning thread, so a
+//               relaxed load + store is enough and avoids a locked RMW on the hot
+//               path. The atomics only exist so that merging from another thread
+//               is well defined
+typedef std::atomic<uint64_t> counter;
+
+inline void bump(counter &c, uint64_t n = 1) noexcept {
+	c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct thread_counters {
+	counter calls[256];
+	counter bytes[256];
+	counter latency[64];
+	counter printf_calls;
+	counter truncations;
+	counter allocations;
+
+	thread_counters();
+	~thread_counters();
+
+	void merge_into(stats &s) const noexcept {
+		for (size_t i = 0; i < 256; ++i) {
+			s.calls[i] += calls[i].load(std::memory_order_relaxed);
+			s.bytes[i] += bytes[i].load(std::memory_order_relaxed);
+		}
+
+		for (size_t i = 0; i < 64; ++i) {
+			s.latency[i] += latency[i].load(std::memory_order_relaxed);
+		}
+
+		s.printf_calls += printf_calls.load(std::memory_order_relaxed);
+		s.truncations  += truncations.load(std::memory_order_relaxed);
+		s.allocations  += allocations.load(std::memory_order_relaxed);
+	}
+
+	void reset() noexcept {
+		for (size_t i = 0; i < 256; ++i) {
+			calls[i].store(0, std::memory_order_relaxed);
+			bytes[i].store(0, std::memory_order_relaxed);
+		}
+
+		for (size_t i = 0; i < 64; ++i) {
+			latency[i].store(0, std::memory_order_relaxed);
+		}
+
+		printf_calls.store(0, std::memory_order_relaxed);
+		truncations.store(0, std::memory_order_relaxed);
+		allocations.store(0, std::memory_order_relaxed);
+	}
+};
+
+// the counters of every live thread, plus the totals of threads which have exited
+struct registry {
+	std::mutex mutex;
+	std::vector<thread_counters *> threads;
+	stats retired;
+};
+
+inline registry &get_registry() {
+	static registry r;
+	return r;
+}
+
+inline thread_counters::thread_counters() {
+	reset();
+	registry &r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	r.threads.push_back(this);
+}
+
+inline thread_counters::~thread_counters() {
+	registry &r = get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+	merge_into(r.retired);
+	for (auto it = r.threads.begin(); it != r.threads.end(); ++it) {
+		if (*it == this) {
+			r.threads.erase(it);
+			break;
+		}
+	}
+}
+
+inline thread_counters &local() {
+	static thread_local thread_counters counters;
+	return counters;
+}
+
+//------------------------------------------------------------------------------
+// Name: cycles
+// Desc: a cheap, monotonic-enough timestamp used for the latency histogram
+//------------------------------------------------------------------------------
+inline uint64_t cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#elif defined(__aarch64__)
+	uint64_t t;
+	__asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(t));
+	return t;
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline size_t log2_bucket(uint64_t n) noexcept {
+	size_t bucket = 0;
+	while (n >>= 1) {
+		++bucket;
+	}
+	return bucket;
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: call_timer
+// Desc: measures the latency of a single Printf call
+//------------------------------------------------------------------------------
+class call_timer {
+public:
+	call_timer() noexcept : start_(detail::cycles()) {
+	}
+
+	~call_timer() {
+		detail::thread_counters &c = detail::local();
+		detail::bump(c.printf_calls);
+		detail::bump(c.latency[detail::log2_bucket(detail::cycles() - start_)]);
+	}
+
+	call_timer(const call_timer &) = delete;
+	call_timer &operator=(const call_timer &) = delete;
+
+private:
+	uint64_t start_;
+};
+
+//------------------------------------------------------------------------------
+// Name: conversion_probe
+// Desc: counts a single conversion and the bytes it produced
+//------------------------------------------------------------------------------
+template <class Context>
+class conversion_probe {
+public:
+	conversion_probe(const Context &ctx, char ch) noexcept : ctx_(ctx), start_(ctx.written), ch_(static_cast<unsigned char>(ch)) {
+	}
+
+	~conversion_probe() {
+		detail::thread_counters &c = detail::local();
+		detail::bump(c.calls[ch_]);
+		detail::bump(c.bytes[ch_], ctx_.written - start_);
+	}
+
+	conversion_probe(const conversion_probe &) = delete;
+	conversion_probe &operator=(const conversion_probe &) = delete;
+
+private:
+	const Context &ctx_;
+	size_t         start_;
+	unsigned char  ch_;
+};
+
+inline void record_truncation() {
+	detail::bump(detail::local().truncations);
+}
+
+inline void record_object(const std::string &s) {
+	// NOTE(eteran): anything which doesn't fit in the small string buffer was heap allocated
+	if (s.capacity() > std::string().capacity()) {
+		detail::bump(detail::local().allocations);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: snapshot
+// Desc: merges the counters of every thread, live or exited
+//------------------------------------------------------------------------------
+inline stats snapshot() {
+	detail::registry &r = detail::get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	stats s = r.retired;
+	for (const detail::thread_counters *c : r.threads) {
+		c->merge_into(s);
+	}
+	return s;
+}
+
+//------------------------------------------------------------------------------
+// Name: reset
+// Desc: zeroes the counters of every thread
+// Note: counts made concurrently with a reset may be lost
+//------------------------------------------------------------------------------
+inline void reset() {
+	detail::registry &r = detail::get_registry();
+	std::lock_guard<std::mutex> lock(r.mutex);
+
+	r.retired = stats();
+	for (detail::thread_counters *c : r.threads) {
+		c->reset();
+	}
+}
+
+namespace detail {
+
+// NOTE(eteran): a malformed format may "convert" any char, only report the sensible ones
+inline bool printable(size_t ch) noexcept {
+	return ch > 0x20 && ch < 0x7f;
+}
+
+inline void append(std::string &out, const char *format, unsigned long long a, unsigned long long b = 0, unsigned long long c = 0) {
+	char buf[128];
+	const int n = snprintf(buf, sizeof(buf), format, a, b, c);
+	out.append(buf, n);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: dump_text
+// Desc: returns a human readable report of the merged counters
+//------------------------------------------------------------------------------
+inline std::string dump_text(const stats &s = snapshot()) {
+
+	std::string out;
+	detail::append(out, "printf calls: %llu\n", s.printf_calls);
+	detail::append(out, "truncations:  %llu\n", s.truncations);
+	detail::append(out, "allocations:  %llu\n", s.allocations);
+
+	out += "conversions:\n";
+	for (size_t i = 0; i < 256; ++i) {
+		if (s.calls[i] && detail::printable(i)) {
+			out += "  %";
+			out += static_cast<char>(i);
+			detail::append(out, "  calls: %llu  bytes: %llu\n", s.calls[i], s.bytes[i]);
+		}
+	}
+
+	out += "latency (cycles):\n";
+	for (size_t i = 0; i < 64; ++i) {
+		if (s.latency[i]) {
+			detail::append(out, "  [2^%llu, 2^%llu)  %llu\n", i, i + 1, s.latency[i]);
+		}
+	}
+
+	return out;
+}
+
+//------------------------------------------------------------------------------
+// Name: dump_json
+// Desc: returns a JSON report of the merged counters
+//------------------------------------------------------------------------------
+inline std::string dump_json(const stats &s = snapshot()) {
+
+	std::string out;
+	detail::append(out, "{\"printf_calls\":%llu,\"truncations\":%llu,\"allocations\":%llu,\"conversions\":{", s.printf_calls, s.truncations, s.allocations);
+
+	bool first = true;
+	for (size_t i = 0; i < 256; ++i) {
+		if (s.calls[i] && detail::printable(i)) {
+			if (!first) {
+				out += ',';
+			}
+			first = false;
+
+			out += '"';
+			if (i == '"' || i == '\\') {
+				out += '\\';
+			}
+			out += static_cast<char>(i);
+			detail::append(out, "\":{\"calls\":%llu,\"bytes\":%llu}", s.calls[i], s.bytes[i]);
+		}
+	}
+
+	out += "},\"latency_log2_cycles\":{";
+
+	first = true;
+	for (size_t i = 0; i < 64; ++i) {
+		if (s.latency[i]) {
+			if (!first) {
+				out += ',';
+			}
+			first = false;
+			detail::append(out, "\"%llu\":%llu", i, s.latency[i]);
+		}
+	}
+
+	out += "}}";
+	return out;
+}
+
+}
+}
+
+#endif
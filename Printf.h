@@ -2,21 +2,132 @@
 #ifndef PRINTF_20160922_H_
 #define PRINTF_20160922_H_
 
+// NOTE(eteran): C++20 relaxes enough of the rules on constexpr functions that
+//               most of the engine can be evaluated at compile time, see
+//               cxx11::format_array. The instrumentation probes can't be, so
+//               it is disabled when they are enabled
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201907L && !defined(CXX11_PRINTF_INSTRUMENT)
+#define CXX11_PRINTF_HAS_CONSTEXPR
+#define CXX11_PRINTF_CONSTEXPR constexpr
+#define CXX11_PRINTF_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#else
+#define CXX11_PRINTF_CONSTEXPR
+#define CXX11_PRINTF_CONSTANT_EVALUATED() false
+#endif
+
 #include "Formatters.h"
+#include "Shortest.h"
+#include "Unicode.h"
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <ctime>
+#include <limits>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 #define CXX11_PRINTF_EXTENSIONS
 
+// NOTE(eteran): formats into a std::array, computing the bound of a literal format
+//               at compile time so that no bounds checks are needed when it fits
+#define CXX11_SPRINTF(str, format, ...) \
+	cxx11::sprintf_bounded<cxx11::format_bound(decltype(cxx11::detail::argument_types(__VA_ARGS__))(), format)>(str, format, ##__VA_ARGS__)
+
+// NOTE(eteran): when exceptions are disabled, errors are reported through the
+//               return value and the context instead of throwing
+#if !defined(CXX11_PRINTF_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS)
+#define CXX11_PRINTF_NO_EXCEPTIONS
+#endif
+
+#ifdef CXX11_PRINTF_NO_EXCEPTIONS
+#define CXX11_PRINTF_NOEXCEPT noexcept
+#else
+#define CXX11_PRINTF_NOEXCEPT
+#endif
+
 namespace cxx11 {
 
+enum class format_errc {
+	none,
+	bad_format,
+	non_integer_argument,
+	non_string_argument,
+	non_pointer_argument,
+	no_to_string,
+	mixed_positional,
+	positional_out_of_range,
+	non_time_argument,
+	non_bytes_argument,
+	non_float_argument,
+	scale_out_of_range
+};
+
+inline const char *error_message(format_errc code) noexcept {
+	switch (code) {
+	case format_errc::none:
+		return "No Error";
+	case format_errc::bad_format:
+		return "Bad Format";
+	case format_errc::non_integer_argument:
+		return "Non-Integer Argument For Integer Format";
+	case format_errc::non_string_argument:
+		return "Non-String Argument For String Format";
+	case format_errc::non_pointer_argument:
+		return "Non-Pointer Argument For Pointer Format";
+	case format_errc::no_to_string:
+		return "No to_string found for this object type";
+	case format_errc::mixed_positional:
+		return "Mixed Positional And Sequential Arguments";
+	case format_errc::positional_out_of_range:
+		return "Positional Argument Out Of Range";
+	case format_errc::non_time_argument:
+		return "Non-Time Argument For Time Format";
+	case format_errc::non_bytes_argument:
+		return "Non-Byte Buffer Argument For Hex Format";
+	case format_errc::non_float_argument:
+		return "Non-Float Argument For Float Format";
+	case format_errc::scale_out_of_range:
+		return "Fixed Point Value Out Of Range For Scale";
+	}
+
+	return "Unknown Error";
+}
+
 struct format_error : std::runtime_error {
 	format_error(const char *what_arg) : std::runtime_error(what_arg) {
 	};
+
+	format_error(format_errc code) : std::runtime_error(error_message(code)), code_(code) {
+	};
+
+	format_errc code() const noexcept {
+		return code_;
+	}
+
+private:
+	format_errc code_ = format_errc::bad_format;
+};
+
+// a (pointer, length) pair of raw bytes, as printed by %y and %Y
+struct bytes {
+	constexpr bytes() : data(nullptr), size(0) {
+	}
+
+	constexpr bytes(const void *data, size_t size) : data(data), size(size) {
+	}
+
+	const void *data;
+	size_t      size;
 };
 
 namespace detail {
@@ -39,412 +150,1586 @@ struct Flags {
 	uint8_t space    : 1;
 	uint8_t prefix   : 1;
 	uint8_t padding  : 1;
-	uint8_t reserved : 3;
+	uint8_t grouping : 1;
+	uint8_t reserved : 2;
 };
 
 static_assert(sizeof(Flags) == sizeof(uint8_t), "");
 
-// NOTE(eteran): by placing this in a class, it allows us to do things like specialization a lot easier
-template <unsigned int Divisor>
-struct itoa_helper;
+// NOTE(eteran): the separator and group size used by the ' flag. Rather than
+//               consulting the global locale, these are taken from the context
+//               if it has "thousands_sep" and "grouping" members
+struct Grouping {
+	char separator;
+	int  size;
+};
 
-template <>
-struct itoa_helper<10> {
-	static constexpr int Divisor = 10;
+template <class Context>
+CXX11_PRINTF_CONSTEXPR auto get_grouping(const Context &ctx, int) -> decltype(ctx.thousands_sep, ctx.grouping, Grouping()) {
+	return Grouping{static_cast<char>(ctx.thousands_sep), static_cast<int>(ctx.grouping)};
+}
 
-public:
-	//------------------------------------------------------------------------------
-	// Name: format
-	// Desc: returns the value of d as a C-string, formatted based on Divisor,
-	//       and flags. places the length of the resultant string in *rlen
-	//------------------------------------------------------------------------------
-	template <class T, size_t N>
-	static const char *format(char (&buf)[N], T d, int width, Flags flags, const char *alphabet, size_t *rlen) {
+template <class Context>
+CXX11_PRINTF_CONSTEXPR Grouping get_grouping(const Context &, long) {
+	return Grouping{',', 3};
+}
 
-		typename std::make_unsigned<T>::type ud = d;
+// NOTE(eteran): the C library's string functions can't be used in constant
+//               expressions, so when evaluated at compile time, these fall back
+//               to simple loops
+inline CXX11_PRINTF_CONSTEXPR size_t string_length(const char *s) noexcept {
+	if (CXX11_PRINTF_CONSTANT_EVALUATED()) {
+		size_t n = 0;
+		while (s[n] != '\0') {
+			++n;
+		}
+		return n;
+	}
 
-		char *p = buf + N;
-		*--p = '\0';
+	return strlen(s);
+}
 
-		// reserve space for leading chars as needed
-		// and if necessary negate the value in ud
-		if (d < 0) {
-			ud = -d;
-			width -= 1;
-		} else if (flags.space) {
-			width -= 1;
-		} else if (flags.sign) {
-			width -= 1;
+inline CXX11_PRINTF_CONSTEXPR const char *find_char(const char *s, char ch) noexcept {
+	if (CXX11_PRINTF_CONSTANT_EVALUATED()) {
+		for (; *s != ch; ++s) {
+			if (*s == '\0') {
+				return nullptr;
+			}
 		}
+		return s;
+	}
 
-		// Divide UD by Divisor until UD == 0.
-		int digits = 0;
-		for (; ud; ud /= Divisor) {
-			const int remainder = (ud % Divisor);
-			*--p = alphabet[remainder];
-			++digits;
-		}
+	return strchr(s, ch);
+}
 
-		// add in any necessary padding
-		if (flags.padding) {
-			while (width-- > digits) {
-				*--p = '0';
+inline CXX11_PRINTF_CONSTEXPR const char *find_char(const char *s, char ch, size_t n) noexcept {
+	if (CXX11_PRINTF_CONSTANT_EVALUATED()) {
+		for (size_t i = 0; i < n; ++i) {
+			if (s[i] == ch) {
+				return s + i;
 			}
 		}
+		return nullptr;
+	}
 
-		// add the prefix as needed
-		if (d < 0) {
-			*--p = '-';
-		} else if (flags.space) {
-			*--p = ' ';
-		} else if (flags.sign) {
-			*--p = '+';
+	return static_cast<const char *>(memchr(s, ch, n));
+}
+
+// NOTE(eteran): and the same for the other character types, which have no
+//               C library equivalents
+template <class Ch>
+inline CXX11_PRINTF_CONSTEXPR size_t string_length(const Ch *s) noexcept {
+	size_t n = 0;
+	while (s[n] != Ch()) {
+		++n;
+	}
+	return n;
+}
+
+template <class Ch>
+inline CXX11_PRINTF_CONSTEXPR const Ch *find_char(const Ch *s, char ch) noexcept {
+	for (; *s != static_cast<Ch>(ch); ++s) {
+		if (*s == Ch()) {
+			return nullptr;
 		}
+	}
+	return s;
+}
 
-		*rlen = (buf + N) - p;
-		return p;
+template <class Ch>
+inline CXX11_PRINTF_CONSTEXPR const Ch *find_char(const Ch *s, char ch, size_t n) noexcept {
+	for (size_t i = 0; i < n; ++i) {
+		if (s[i] == static_cast<Ch>(ch)) {
+			return s + i;
+		}
 	}
-};
+	return nullptr;
+}
 
-// Specialization for base 16 so we can make some assumptions
-template <>
-struct itoa_helper<16> {
-	static constexpr int Shift = 4;
-	static constexpr int Mask  = 0x0f;
+//------------------------------------------------------------------------------
+// Name: parse_long
+// Desc: equivalent to strtol(format, &endptr, 10), moving format to endptr
+//------------------------------------------------------------------------------
+template <class CharT>
+inline CXX11_PRINTF_CONSTEXPR long int parse_long(const CharT *&format) noexcept {
 
-public:
-	//------------------------------------------------------------------------------
-	// Name: format
-	// Desc: returns the value of d as a C-string, formatted based on Divisor,
-	//       and flags. places the length of the resultant string in *rlen
-	//------------------------------------------------------------------------------
-	template <class T, size_t N>
-	static const char *format(char (&buf)[N], T d, int width, Flags flags, const char *alphabet, size_t *rlen) {
+	const CharT *p = format;
+	while (*p == ' ' || (*p >= '\t' && *p <= '\r')) {
+		++p;
+	}
 
-		typename std::make_unsigned<T>::type ud = d;
+	bool negative = false;
+	if (*p == '+' || *p == '-') {
+		negative = (*p == '-');
+		++p;
+	}
 
-		char *p = buf + N;
-		*--p = '\0';
+	// no digits, no conversion
+	if (*p < '0' || *p > '9') {
+		return 0;
+	}
 
-		// add the prefix as needed
-		if (flags.prefix) {
-			width -= 2;
-		}
+	const unsigned long int max = static_cast<unsigned long int>(std::numeric_limits<long int>::max()) + negative;
 
-		// Divide UD by Divisor until UD == 0.
-		int digits = 0;
-		for (; ud; ud >>= Shift) {
-			const int remainder = (ud & Mask);
-			*--p = alphabet[remainder];
-			++digits;
+	unsigned long int n = 0;
+	bool overflow       = false;
+	for (; *p >= '0' && *p <= '9'; ++p) {
+		const unsigned long int digit = *p - '0';
+		if (n > (max - digit) / 10) {
+			overflow = true;
+		} else {
+			n = n * 10 + digit;
 		}
+	}
 
-		// add in any necessary padding
-		if (flags.padding) {
-			while (width-- > digits) {
-				*--p = '0';
-			}
-		}
+	format = p;
 
-		// add the prefix as needed
-		if (flags.prefix) {
-			*--p = alphabet[16];
-			*--p = '0';
-		}
+	if (overflow) {
+		n = max;
+	}
 
-		*rlen = (buf + N) - p;
-		return p;
+	if (negative) {
+		return (n == 0) ? 0 : -static_cast<long int>(n - 1) - 1;
 	}
+
+	return static_cast<long int>(n);
+}
+
+// NOTE(eteran): we include the x/X, here as an easy way to put the
+//               upper/lower case prefix for hex numbers
+static const char alphabet_l[] = "0123456789abcdefx";
+static const char alphabet_u[] = "0123456789ABCDEFX";
+
+// NOTE(eteran): every two digit decimal number, so that decimal conversions only
+//               need one division for every two digits
+static const char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// the powers of ten which fit in 64 bits, used to count decimal digits
+#if defined(__GNUC__) || defined(__clang__)
+static const uint64_t decimal_powers[] = {
+	1ull,
+	10ull,
+	100ull,
+	1000ull,
+	10000ull,
+	100000ull,
+	1000000ull,
+	10000000ull,
+	100000000ull,
+	1000000000ull,
+	10000000000ull,
+	100000000000ull,
+	1000000000000ull,
+	10000000000000ull,
+	100000000000000ull,
+	1000000000000000ull,
+	10000000000000000ull,
+	100000000000000000ull,
+	1000000000000000000ull,
+	10000000000000000000ull,
 };
+#endif
+
+// NOTE(eteran): by placing this in a class, it allows us to do things like specialization a lot easier.
+//               Each specialization knows how to write the prefix of a number, count
+//               its digits, and generate them backwards
+template <unsigned int Divisor>
+struct itoa_helper;
 
-// Specialization for base 8 so we can make some assumptions
 template <>
-struct itoa_helper<8> {
-	static constexpr int Shift = 3;
-	static constexpr int Mask  = 0x07;
+struct itoa_helper<10> {
+	static constexpr int Divisor = 10;
 
 public:
+	static CXX11_PRINTF_CONSTEXPR size_t prefix(char *out, bool negative, Flags flags, const char *alphabet) {
+		(void)alphabet;
+		if (negative) {
+			*out = '-';
+		} else if (flags.space) {
+			*out = ' ';
+		} else if (flags.sign) {
+			*out = '+';
+		} else {
+			return 0;
+		}
+		return 1;
+	}
+
 	//------------------------------------------------------------------------------
-	// Name: format
-	// Desc: returns the value of d as a C-string, formatted based on Divisor,
-	//       and flags. places the length of the resultant string in *rlen
+	// Name: count
+	// Desc: returns the number of chars generate will write for ud, including any
+	//       thousands separators
 	//------------------------------------------------------------------------------
-	template <class T, size_t N>
-	static const char *format(char (&buf)[N], T d, int width, Flags flags, const char *alphabet, size_t *rlen) {
+	template <class U>
+	static CXX11_PRINTF_CONSTEXPR size_t count(U ud, Flags flags, Grouping grouping) {
+
+#if defined(__GNUC__) || defined(__clang__)
+		// NOTE(eteran): log10(2) ~= 1233/4096, which gives the number of digits
+		//               from the number of bits, give or take one. Setting the low
+		//               bit changes nothing but makes 0 count as a digit
+		const unsigned long long v = static_cast<unsigned long long>(ud) | 1;
+		const int bits             = 64 - __builtin_clzll(v);
+		const int estimate         = (bits * 1233) >> 12;
+		size_t digits              = estimate + (v >= decimal_powers[estimate]);
+#else
+		// NOTE(eteran): four comparisons per division keeps this much cheaper
+		//               than generating the digits
+		size_t digits = 1;
+		while (true) {
+			if (ud < 10) {
+				break;
+			}
+			if (ud < 100) {
+				digits += 1;
+				break;
+			}
+			if (ud < 1000) {
+				digits += 2;
+				break;
+			}
+			if (ud < 10000) {
+				digits += 3;
+				break;
+			}
+			ud /= 10000;
+			digits += 4;
+		}
+#endif
 
-		typename std::make_unsigned<T>::type ud = d;
+		if (flags.grouping && grouping.size > 0) {
+			digits += (digits - 1) / grouping.size;
+		}
 
-		char *p = buf + N;
-		*--p = '\0';
+		return digits;
+	}
 
-		// add the prefix as needed
-		if (flags.prefix) {
-			width -= 1;
-		}
+	//------------------------------------------------------------------------------
+	// Name: generate
+	// Desc: writes the digits of ud backwards ending at p, returns the new start
+	//------------------------------------------------------------------------------
+	template <class Ch, class U>
+	static CXX11_PRINTF_CONSTEXPR Ch *generate(Ch *p, U ud, Flags flags, Grouping grouping, const char *alphabet) {
 
 		// Divide UD by Divisor until UD == 0.
-		int digits = 0;
-		for (; ud; ud >>= Shift) {
-			const int remainder = (ud & Mask);
-			*--p = alphabet[remainder];
-			++digits;
-		}
-
-		// add in any necessary padding
-		if (flags.padding) {
-			while (width-- > digits) {
-				*--p = '0';
+		// NOTE(eteran): the thousands separators are inserted as the digits are
+		//               generated, so grouping costs no extra pass over the string
+		if (flags.grouping && grouping.size > 0) {
+			int group = 0;
+			do {
+				if (group == grouping.size) {
+					*--p = grouping.separator;
+					group = 0;
+				}
+				const int remainder = (ud % Divisor);
+				*--p = alphabet[remainder];
+				++group;
+			} while (ud /= Divisor);
+		} else {
+			while (ud >= 100) {
+				const int remainder = static_cast<int>(ud % 100) * 2;
+				ud /= 100;
+				*--p = digit_pairs[remainder + 1];
+				*--p = digit_pairs[remainder];
 			}
-		}
 
-		// add the prefix as needed
-		if (flags.prefix) {
-			*--p = '0';
+			if (ud >= 10) {
+				const int remainder = static_cast<int>(ud) * 2;
+				*--p = digit_pairs[remainder + 1];
+				*--p = digit_pairs[remainder];
+			} else {
+				*--p = alphabet[ud];
+			}
 		}
 
-		*rlen = (buf + N) - p;
 		return p;
 	}
 };
 
-// Specialization for base 2 so we can make some assumptions
-template <>
-struct itoa_helper<2> {
-	static constexpr int Shift = 1;
-	static constexpr int Mask  = 0x01;
+// NOTE(eteran): bases which are a power of two can use shifts and masks
+template <int Shift>
+struct itoa_helper_pow2 {
+	static constexpr int Mask = (1 << Shift) - 1;
 
 public:
-	//------------------------------------------------------------------------------
-	// Name: format
-	// Desc: returns the value of d as a C-string, formatted based on Divisor,
-	//       and flags. places the length of the resultant string in *rlen
-	//------------------------------------------------------------------------------
-	template <class T, size_t N>
-	static const char *format(char (&buf)[N], T d, int width, Flags flags, const char *alphabet, size_t *rlen) {
-
-		typename std::make_unsigned<T>::type ud = d;
-
-		char *p = buf + N;
-		*--p = '\0';
-
-		// add the prefix as needed
-		if (flags.prefix) {
-			width -= 2;
+	template <class U>
+	static CXX11_PRINTF_CONSTEXPR size_t count(U ud, Flags flags, Grouping grouping) {
+		(void)flags;
+		(void)grouping;
+		size_t digits = 1;
+		while (ud >>= Shift) {
+			++digits;
 		}
+		return digits;
+	}
 
-		// Divide UD by Divisor until UD == 0.
-		int digits = 0;
-		for (; ud; ud >>= Shift) {
+	template <class Ch, class U>
+	static CXX11_PRINTF_CONSTEXPR Ch *generate(Ch *p, U ud, Flags flags, Grouping grouping, const char *alphabet) {
+		(void)flags;
+		(void)grouping;
+		do {
 			const int remainder = (ud & Mask);
 			*--p = alphabet[remainder];
-			++digits;
-		}
+		} while (ud >>= Shift);
+		return p;
+	}
+};
 
-		// add in any necessary padding
-		if (flags.padding) {
-			while (width-- > digits) {
-				*--p = '0';
-			}
+// Specialization for base 16 so we can make some assumptions
+template <>
+struct itoa_helper<16> : itoa_helper_pow2<4> {
+	static CXX11_PRINTF_CONSTEXPR size_t prefix(char *out, bool negative, Flags flags, const char *alphabet) {
+		(void)negative;
+		if (!flags.prefix) {
+			return 0;
 		}
+		out[0] = '0';
+		out[1] = alphabet[16];
+		return 2;
+	}
+};
 
-		// add the prefix as needed
-		if (flags.prefix) {
-			*--p = 'b';
-			*--p = '0';
+// Specialization for base 8 so we can make some assumptions
+template <>
+struct itoa_helper<8> : itoa_helper_pow2<3> {
+	static CXX11_PRINTF_CONSTEXPR size_t prefix(char *out, bool negative, Flags flags, const char *alphabet) {
+		(void)negative;
+		(void)alphabet;
+		if (!flags.prefix) {
+			return 0;
 		}
+		out[0] = '0';
+		return 1;
+	}
+};
 
-		*rlen = (buf + N) - p;
-		return p;
+// Specialization for base 2 so we can make some assumptions
+template <>
+struct itoa_helper<2> : itoa_helper_pow2<1> {
+	static CXX11_PRINTF_CONSTEXPR size_t prefix(char *out, bool negative, Flags flags, const char *alphabet) {
+		(void)negative;
+		(void)alphabet;
+		if (!flags.prefix) {
+			return 0;
+		}
+		out[0] = '0';
+		out[1] = 'b';
+		return 2;
 	}
 };
 
-//------------------------------------------------------------------------------
-// Name: itoa
-// Desc: as a minor optimization, let's determine a few things up front and pass
-//       them as template parameters enabling some more aggressive optimizations
-//       when the division can use more efficient operations
-//------------------------------------------------------------------------------
-template <class T, size_t N>
-const char *itoa(char (&buf)[N], char base, int precision, T d, int width, Flags flags, size_t *rlen) {
+// NOTE(eteran): contexts which write something other than char, such as char16_t,
+//               say so with a char_type member. The format must be of that type
+template <class Context>
+struct context_char {
+private:
+	template <class C>
+	static typename C::char_type test(int);
 
-	if (d == 0 && precision == 0) {
-		*buf = '\0';
-		*rlen = 0;
-		return buf;
-	}
+	template <class C>
+	static char test(long);
+
+public:
+	typedef decltype(test<Context>(0)) type;
+};
 
-	// NOTE(eteran): we include the x/X, here as an easy way to put the
-	//               upper/lower case prefix for hex numbers
-	static const char alphabet_l[] = "0123456789abcdefx";
-	static const char alphabet_u[] = "0123456789ABCDEFX";
+// NOTE(eteran): contexts may optionally offer to let us write directly into their
+//               memory. reserve(n) returns a pointer to at least n writable chars,
+//               or nullptr if that is not possible right now, and commit(n) then
+//               marks n of them as written
+template <class Context>
+struct has_reserve {
+private:
+	template <class C>
+	static auto test(int) -> decltype(std::declval<C &>().commit(size_t()), static_cast<typename context_char<C>::type *>(std::declval<C &>().reserve(size_t())), std::true_type());
 
-	switch (base) {
-	case 'i':
-	case 'd':
-	case 'u':
-		return itoa_helper<10>::format(buf, d, width, flags, alphabet_l, rlen);
-#ifdef CXX11_PRINTF_EXTENSIONS
-	case 'b':
-		return itoa_helper<2>::format(buf, d, width, flags, alphabet_l, rlen);
-#endif
-	case 'X':
-		return itoa_helper<16>::format(buf, d, width, flags, alphabet_u, rlen);
-	case 'x':
-		return itoa_helper<16>::format(buf, d, width, flags, alphabet_l, rlen);
-	case 'o':
-		return itoa_helper<8>::format(buf, d, width, flags, alphabet_l, rlen);
-	default:
-		return itoa_helper<10>::format(buf, d, width, flags, alphabet_l, rlen);
-	}
-}
+	template <class C>
+	static std::false_type test(long);
+
+public:
+	static constexpr bool value = decltype(test<Context>(0))::value;
+};
 
 //------------------------------------------------------------------------------
-// Name: output_string
-// Desc: prints a string to the Context object, taking into account padding flags
-// Note: ch is the current format specifier
+// Name: write_chars
+// Desc: writes n chars of any character type to the Context. Anything which
+//       isn't of the Context's own type, such as the ASCII produced for numbers
+//       in a char16_t Context, is transcoded on the way
 //------------------------------------------------------------------------------
-template <class Context>
-void output_string(char ch, const char *s_ptr, int precision, long int width, Flags flags, int len, Context &ctx) {
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR void write_chars(Context &ctx, const Ch *p, size_t n, std::true_type) CXX11_PRINTF_NOEXCEPT {
+	ctx.write(p, n);
+}
 
-	if ((ch == 's' && precision >= 0 && precision < len)) {
-		len = precision;
-	}
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR void write_chars(Context &ctx, const Ch *p, size_t n, std::false_type) CXX11_PRINTF_NOEXCEPT {
 
-	// if not left justified padding goes first...
-	if (!flags.justify) {
-		// spaces go before the prefix...
-		while (width-- > len) {
-			ctx.write(' ');
-		}
-	}
+	typedef typename context_char<Context>::type char_type;
 
-	// output the string
-	// NOTE(eteran): len is at most strlen, possible is less
-	// so we can just loop len times
-	width -= len;
-	ctx.write(s_ptr, len);
+	char_type buf[64];
+	size_t    used = 0;
 
-	// if left justified padding goes last...
-	if (flags.justify) {
-		while (width-- > 0) {
-			ctx.write(' ');
+	const Ch *const end = p + n;
+	while (p != end) {
+		if (used > sizeof(buf) / sizeof(buf[0]) - 4) {
+			ctx.write(buf, used);
+			used = 0;
 		}
+		used += unicode::encode(unicode::decode(p, end), buf + used);
 	}
-}
 
-// NOTE(eteran): Here is some code to fetch arguments of specific types. We also need a few
-//               default handlers, this code should never really be encountered, but
-//               but we need it to keep the linker happy.
-
-#ifdef CXX11_PRINTF_EXTENSIONS
-inline std::string formatted_object(std::string obj) {
-	return obj;
+	if (used != 0) {
+		ctx.write(buf, used);
+	}
 }
 
-template <class T>
-std::string to_string(T) {
-	throw format_error("No to_string found for this object type");
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR void write_chars(Context &ctx, const Ch *p, size_t n) CXX11_PRINTF_NOEXCEPT {
+	write_chars(ctx, p, n, std::is_same<Ch, typename context_char<Context>::type>());
 }
 
-template <class T>
-std::string formatted_object(T obj) {
-	using std::to_string;
-	using detail::to_string;
-	return to_string(obj);
+//------------------------------------------------------------------------------
+// Name: written_length
+// Desc: returns the number of chars write_chars will write for n chars at p
+//------------------------------------------------------------------------------
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR size_t written_length(const Ch *p, size_t n, std::true_type) noexcept {
+	(void)p;
+	return n;
 }
-#endif
 
-template <class T>
-const char *formatted_string(T s, typename std::enable_if<std::is_convertible<T, const char *>::value>::type * = 0) {
-	return s;
-}
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR size_t written_length(const Ch *p, size_t n, std::false_type) noexcept {
 
-template <class T>
-const char *formatted_string(T s, typename std::enable_if<!std::is_convertible<T, const char *>::value>::type * = 0) {
-	(void)s;
-	throw format_error("Non-String Argument For String Format");
+	size_t len = 0;
+
+	const Ch *const end = p + n;
+	while (p != end) {
+		len += unicode::encoded_length<typename context_char<Context>::type>(unicode::decode(p, end));
+	}
+
+	return len;
 }
 
-template <class R, class T>
-R formatted_pointer(T p, typename std::enable_if<std::is_convertible<T, const void *>::value>::type * = 0) {
-	return reinterpret_cast<R>(reinterpret_cast<uintptr_t>(p));
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR size_t written_length(const Ch *p, size_t n) noexcept {
+	return written_length<Context>(p, n, std::is_same<Ch, typename context_char<Context>::type>());
 }
 
-template <class R, class T>
-R formatted_pointer(T p, typename std::enable_if<!std::is_convertible<T, const void *>::value>::type * = 0) {
-	(void)p;
-	throw format_error("Non-Pointer Argument For Pointer Format");
+//------------------------------------------------------------------------------
+// Name: written_prefix
+// Desc: returns how many of the n chars at p write_chars can write without
+//       writing more than limit chars, stopping before any code point which
+//       would not fit. places the number of chars written in *len
+//------------------------------------------------------------------------------
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR size_t written_prefix(const Ch *p, size_t n, size_t limit, size_t *len, std::true_type) noexcept {
+	// NOTE(eteran): nothing is transcoded, but a cut may still not split a code point
+	*len = (n <= limit) ? n : unicode::truncate(p, p + n, limit);
+	return *len;
 }
 
-template <class R, class T>
-R formatted_integer(T n, typename std::enable_if<std::is_integral<T>::value>::type * = 0) {
-	return static_cast<R>(n);
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR size_t written_prefix(const Ch *p, size_t n, size_t limit, size_t *len, std::false_type) noexcept {
+
+	size_t written = 0;
+
+	const Ch *const first = p;
+	const Ch *const end   = p + n;
+	while (p != end) {
+		const Ch *next     = p;
+		const size_t units = unicode::encoded_length<typename context_char<Context>::type>(unicode::decode(next, end));
+		if (units > limit - written) {
+			break;
+		}
+
+		written += units;
+		p = next;
+	}
+
+	*len = written;
+	return p - first;
 }
 
-template <class R, class T>
-R formatted_integer(T n, typename std::enable_if<!std::is_integral<T>::value>::type * = 0) {
-	(void)n;
-	throw format_error("Non-Integer Argument For Integer Format");
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR size_t written_prefix(const Ch *p, size_t n, size_t limit, size_t *len) noexcept {
+	return written_prefix<Context>(p, n, limit, len, std::is_same<Ch, typename context_char<Context>::type>());
 }
 
-//------------------------------------------------------------------------------
-// Name: process_format
-// Desc: default handler that should never be called at runtime
-//------------------------------------------------------------------------------
 template <class Context>
-int process_format(Context &ctx, const char *format, Flags flags, long int width, long int precision, Modifiers modifier) {
-	(void)ctx;
-	(void)format;
-	(void)flags;
-	(void)width;
-	(void)precision;
-	(void)modifier;
-	throw format_error("Should Never Happen");
+CXX11_PRINTF_CONSTEXPR void write_repeated(Context &ctx, char ch, size_t n) CXX11_PRINTF_NOEXCEPT {
+	while (n--) {
+		ctx.write(ch);
+	}
 }
 
-//------------------------------------------------------------------------------
-// Name: get_modifier
-// Desc: default handler that should never be called at runtime
-//------------------------------------------------------------------------------
-template <class Context>
-int get_modifier(Context &ctx, const char *format, Flags flags, long int width, long int precision) {
-	(void)ctx;
-	(void)format;
-	(void)flags;
-	(void)width;
-	(void)precision;
-	throw format_error("Should Never Happen");
+// where the padding of a number goes, zeros go between the prefix and the
+// digits, spaces around everything
+struct number_layout {
+	CXX11_PRINTF_CONSTEXPR number_layout(long int width, size_t prefix_len, size_t digits, Flags flags) noexcept {
+		size_t len = prefix_len + digits;
+		zeros = 0;
+		if (flags.padding && width > static_cast<long int>(len)) {
+			zeros = width - len;
+			len   = width;
+		}
+
+		spaces = (width > static_cast<long int>(len)) ? width - len : 0;
+		total  = len + spaces;
+	}
+
+	size_t zeros;
+	size_t spaces;
+	size_t total;
+};
+
+//------------------------------------------------------------------------------
+// Name: output_digits
+// Desc: prints ud to the Context in the given base, taking into account the
+//       padding flags. The digits are generated into a temporary buffer and the
+//       pieces are written one after the other
+//------------------------------------------------------------------------------
+template <unsigned int Base, class Context>
+CXX11_PRINTF_CONSTEXPR void output_digits(Context &ctx, uintmax_t ud, const char *prefix, size_t prefix_len, long int width, Flags flags, Grouping grouping, const char *alphabet, std::false_type) CXX11_PRINTF_NOEXCEPT {
+
+	typedef typename context_char<Context>::type char_type;
+
+	// enough to contain a 64-bit number in bin notation, or a grouped decimal one
+	char_type        buf[64];
+	const char_type *first  = itoa_helper<Base>::generate(buf + 64, ud, flags, grouping, alphabet);
+	const size_t     digits = (buf + 64) - first;
+
+	const number_layout layout(width, prefix_len, digits, flags);
+
+	if (!flags.justify) {
+		write_repeated(ctx, ' ', layout.spaces);
+	}
+
+	if (prefix_len != 0) {
+		write_chars(ctx, prefix, prefix_len);
+	}
+
+	write_repeated(ctx, '0', layout.zeros);
+	ctx.write(first, digits);
+
+	if (flags.justify) {
+		write_repeated(ctx, ' ', layout.spaces);
+	}
 }
 
 //------------------------------------------------------------------------------
-// Name: get_precision
-// Desc: default handler that should never be called at runtime
+// Name: output_digits
+// Desc: as above, but the digits are counted first so that everything can be
+//       written directly into the context's memory. Falls back to the copy if
+//       the context can't reserve enough space
+//------------------------------------------------------------------------------
+template <unsigned int Base, class Context>
+CXX11_PRINTF_CONSTEXPR void output_digits(Context &ctx, uintmax_t ud, const char *prefix, size_t prefix_len, long int width, Flags flags, Grouping grouping, const char *alphabet, std::true_type) CXX11_PRINTF_NOEXCEPT {
+
+	const size_t        digits = itoa_helper<Base>::count(ud, flags, grouping);
+	const number_layout layout(width, prefix_len, digits, flags);
+
+	typename context_char<Context>::type *p = ctx.reserve(layout.total);
+	if (!p) {
+		output_digits<Base>(ctx, ud, prefix, prefix_len, width, flags, grouping, alphabet, std::false_type());
+		return;
+	}
+
+	// NOTE(eteran): the pieces are typically only a few chars long, so simple
+	//               loops beat calls to memset and memcpy here
+	if (!flags.justify) {
+		for (size_t i = 0; i < layout.spaces; ++i) {
+			*p++ = ' ';
+		}
+	}
+
+	for (size_t i = 0; i < prefix_len; ++i) {
+		*p++ = prefix[i];
+	}
+
+	for (size_t i = 0; i < layout.zeros; ++i) {
+		*p++ = '0';
+	}
+
+	p += digits;
+	itoa_helper<Base>::generate(p, ud, flags, grouping, alphabet);
+
+	if (flags.justify) {
+		for (size_t i = 0; i < layout.spaces; ++i) {
+			*p++ = ' ';
+		}
+	}
+
+	ctx.commit(layout.total);
+}
+
+//------------------------------------------------------------------------------
+// Name: output_digits
+// Desc: prints the magnitude ud to the Context in the given base
+// Note: every integer type shares the uintmax_t code, which keeps the number of
+//       instantiations per Context down
+//------------------------------------------------------------------------------
+template <unsigned int Base, class Context>
+CXX11_PRINTF_CONSTEXPR void output_digits(Context &ctx, bool negative, uintmax_t ud, long int width, Flags flags, Grouping grouping, const char *alphabet) CXX11_PRINTF_NOEXCEPT {
+
+	char         prefix[2];
+	const size_t prefix_len = itoa_helper<Base>::prefix(prefix, negative, flags, alphabet);
+
+	output_digits<Base>(ctx, ud, prefix, prefix_len, width, flags, grouping, alphabet, std::integral_constant<bool, has_reserve<Context>::value>());
+}
+
+//------------------------------------------------------------------------------
+// Name: output_integer
+// Desc: as a minor optimization, let's determine a few things up front and pass
+//       them as template parameters enabling some more aggressive optimizations
+//       when the division can use more efficient operations. Nothing is printed
+//       if there was an error getting the argument. Always returns true
+//------------------------------------------------------------------------------
+template <class Context, class T>
+CXX11_PRINTF_CONSTEXPR bool output_integer(Context &ctx, char base, long int precision, T d, long int width, Flags flags, Grouping grouping, const format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	if (err != format_errc::none) {
+		return true;
+	}
+
+	// NOTE(eteran): a zero with a precision of zero prints no digits at all
+	if (d == 0 && precision == 0) {
+		write_repeated(ctx, ' ', (width > 0) ? width : 0);
+		return true;
+	}
+
+	typedef typename std::make_unsigned<T>::type U;
+
+	const bool negative = d < 0;
+	const U    ud       = negative ? U(0) - static_cast<U>(d) : static_cast<U>(d);
+
+	switch (base) {
+	case 'i':
+	case 'd':
+	case 'u':
+		output_digits<10>(ctx, negative, ud, width, flags, grouping, alphabet_l);
+		break;
+#ifdef CXX11_PRINTF_EXTENSIONS
+	case 'b':
+		output_digits<2>(ctx, negative, ud, width, flags, grouping, alphabet_l);
+		break;
+#endif
+	case 'X':
+		output_digits<16>(ctx, negative, ud, width, flags, grouping, alphabet_u);
+		break;
+	case 'x':
+		output_digits<16>(ctx, negative, ud, width, flags, grouping, alphabet_l);
+		break;
+	case 'o':
+		output_digits<8>(ctx, negative, ud, width, flags, grouping, alphabet_l);
+		break;
+	default:
+		output_digits<10>(ctx, negative, ud, width, flags, grouping, alphabet_l);
+		break;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: output_string
+// Desc: prints a string to the Context object, taking into account padding flags
+// Note: ch is the current format specifier
+//------------------------------------------------------------------------------
+template <class Context, class Ch>
+CXX11_PRINTF_CONSTEXPR void output_string(char ch, const Ch *s_ptr, int precision, long int width, Flags flags, int len, Context &ctx) CXX11_PRINTF_NOEXCEPT {
+
+	// NOTE(eteran): the precision and padding are by the chars written, which
+	//               differs from the chars read when transcoding
+	int in_len = len;
+	if (ch == 's' && precision >= 0) {
+		size_t written = 0;
+		in_len = static_cast<int>(written_prefix<Context>(s_ptr, len, precision, &written));
+		len    = static_cast<int>(written);
+	} else {
+		len = static_cast<int>(written_length<Context>(s_ptr, in_len));
+	}
+
+	// if not left justified padding goes first...
+	if (!flags.justify) {
+		// spaces go before the prefix...
+		while (width-- > len) {
+			ctx.write(' ');
+		}
+	}
+
+	// output the string
+	// NOTE(eteran): len is at most strlen, possible is less
+	// so we can just loop len times
+	width -= len;
+	write_chars(ctx, s_ptr, in_len);
+
+	// if left justified padding goes last...
+	if (flags.justify) {
+		while (width-- > 0) {
+			ctx.write(' ');
+		}
+	}
+}
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+//------------------------------------------------------------------------------
+// Name: hex_encode
+// Desc: writes the n bytes at p to out as 2n hex digits using alphabet
+//------------------------------------------------------------------------------
+inline void hex_encode(char *out, const uint8_t *p, size_t n, const char *alphabet) noexcept {
+
+#if defined(__SSE2__) || defined(_M_X64)
+	// NOTE(eteran): converts 16 bytes per iteration. Each nibble becomes
+	//               '0' + nibble, plus the distance to the alphabet's 'a' (or 'A')
+	//               for the nibbles greater than 9
+	const __m128i mask   = _mm_set1_epi8(0x0f);
+	const __m128i nine   = _mm_set1_epi8(9);
+	const __m128i zero   = _mm_set1_epi8('0');
+	const __m128i letter = _mm_set1_epi8(static_cast<char>(alphabet[10] - '0' - 10));
+
+	while (n >= 16) {
+		const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+		const __m128i lo = _mm_and_si128(v, mask);
+
+		// interleave so that the high nibble of each byte comes first
+		__m128i a = _mm_unpacklo_epi8(hi, lo);
+		__m128i b = _mm_unpackhi_epi8(hi, lo);
+
+		a = _mm_add_epi8(_mm_add_epi8(a, zero), _mm_and_si128(_mm_cmpgt_epi8(a, nine), letter));
+		b = _mm_add_epi8(_mm_add_epi8(b, zero), _mm_and_si128(_mm_cmpgt_epi8(b, nine), letter));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out), a);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), b);
+
+		p   += 16;
+		out += 32;
+		n   -= 16;
+	}
+#endif
+
+	while (n--) {
+		*out++ = alphabet[*p >> 4];
+		*out++ = alphabet[*p & 0x0f];
+		++p;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: output_hex
+// Desc: prints n bytes as hex to the Context, optionally separated by spaces
+//       (' ' flag) or colons ('#' flag), taking into account padding flags
+//------------------------------------------------------------------------------
+template <class Context>
+void output_hex(const uint8_t *p, size_t n, long int width, Flags flags, const char *alphabet, Context &ctx) CXX11_PRINTF_NOEXCEPT {
+
+	const char separator = flags.prefix ? ':' : flags.space ? ' ' : '\0';
+
+	// NOTE(eteran): the length is known up front, so padding costs nothing extra
+	const size_t len = (separator && n != 0) ? n * 3 - 1 : n * 2;
+	long int     pad = width - static_cast<long int>(len);
+
+	// if not left justified padding goes first...
+	if (!flags.justify) {
+		while (pad-- > 0) {
+			ctx.write(' ');
+		}
+	}
+
+	// NOTE(eteran): convert into a small buffer, so each block of output is
+	//               a single write to the context
+	char buf[768];
+
+	if (!separator) {
+		while (n != 0) {
+			const size_t count = std::min<size_t>(n, sizeof(buf) / 2);
+			hex_encode(buf, p, count, alphabet);
+			write_chars(ctx, buf, count * 2);
+			p += count;
+			n -= count;
+		}
+	} else {
+		bool first = true;
+		while (n != 0) {
+			const size_t count = std::min<size_t>(n, sizeof(buf) / 3);
+			char *out = buf;
+			for (size_t i = 0; i < count; ++i) {
+				if (!first) {
+					*out++ = separator;
+				}
+				first  = false;
+				*out++ = alphabet[p[i] >> 4];
+				*out++ = alphabet[p[i] & 0x0f];
+			}
+			write_chars(ctx, buf, out - buf);
+			p += count;
+			n -= count;
+		}
+	}
+
+	// if left justified padding goes last...
+	if (flags.justify) {
+		while (pad-- > 0) {
+			ctx.write(' ');
+		}
+	}
+}
+#endif
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+inline CXX11_PRINTF_CONSTEXPR bool needs_escape(unsigned char ch, bool c_style) noexcept {
+	return ch < 0x20 || ch == '"' || ch == '\\' || (c_style && ch == 0x7f);
+}
+
+//------------------------------------------------------------------------------
+// Name: escape_scan
+// Desc: returns the index of the first of the n chars at p which needs to be
+//       escaped, or n if there is none
+//------------------------------------------------------------------------------
+inline CXX11_PRINTF_CONSTEXPR size_t escape_scan(const char *p, size_t n, bool c_style) noexcept {
+
+	size_t i = 0;
+
+#if defined(__SSE2__) || defined(_M_X64)
+	if (!CXX11_PRINTF_CONSTANT_EVALUATED()) {
+		// NOTE(eteran): there is no unsigned compare in SSE2, but x <= 0x1f exactly
+		//               when max(x, 0x1f) == 0x1f
+		const __m128i control   = _mm_set1_epi8(0x1f);
+		const __m128i quote     = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i del       = _mm_set1_epi8(c_style ? 0x7f : '"');
+
+		for (; i + 16 <= n; i += 16) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+
+			__m128i m = _mm_cmpeq_epi8(_mm_max_epu8(v, control), control);
+			m         = _mm_or_si128(m, _mm_cmpeq_epi8(v, quote));
+			m         = _mm_or_si128(m, _mm_cmpeq_epi8(v, backslash));
+			m         = _mm_or_si128(m, _mm_cmpeq_epi8(v, del));
+
+			const int mask = _mm_movemask_epi8(m);
+			if (mask != 0) {
+#if defined(__GNUC__)
+				return i + __builtin_ctz(mask);
+#else
+				while (!needs_escape(static_cast<unsigned char>(p[i]), c_style)) {
+					++i;
+				}
+				return i;
+#endif
+			}
+		}
+	}
+#endif
+
+	for (; i < n; ++i) {
+		if (needs_escape(static_cast<unsigned char>(p[i]), c_style)) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+//------------------------------------------------------------------------------
+// Name: short_escape
+// Desc: returns the char following the backslash in the short escape sequence
+//       for ch, or '\0' if there is none
+//------------------------------------------------------------------------------
+inline CXX11_PRINTF_CONSTEXPR char short_escape(unsigned char ch, bool c_style) noexcept {
+	switch (ch) {
+	case '"':
+		return '"';
+	case '\\':
+		return '\\';
+	case '\b':
+		return 'b';
+	case '\f':
+		return 'f';
+	case '\n':
+		return 'n';
+	case '\r':
+		return 'r';
+	case '\t':
+		return 't';
+	case '\a':
+		return c_style ? 'a' : '\0';
+	case '\v':
+		return c_style ? 'v' : '\0';
+	default:
+		return '\0';
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: escape_char
+// Desc: writes the escape sequence for ch to out, returns its length. JSON uses
+//       \u00XX for control chars without a short form, C uses 3 digit octal
+//------------------------------------------------------------------------------
+inline CXX11_PRINTF_CONSTEXPR size_t escape_char(char *out, unsigned char ch, bool c_style) noexcept {
+
+	out[0] = '\\';
+
+	if (const char e = short_escape(ch, c_style)) {
+		out[1] = e;
+		return 2;
+	}
+
+	if (c_style) {
+		out[1] = static_cast<char>('0' + (ch >> 6));
+		out[2] = static_cast<char>('0' + ((ch >> 3) & 7));
+		out[3] = static_cast<char>('0' + (ch & 7));
+		return 4;
+	}
+
+	out[1] = 'u';
+	out[2] = '0';
+	out[3] = '0';
+	out[4] = alphabet_l[ch >> 4];
+	out[5] = alphabet_l[ch & 0x0f];
+	return 6;
+}
+
+//------------------------------------------------------------------------------
+// Name: escaped_length
+// Desc: returns the length of the n chars at p once escaped
+//------------------------------------------------------------------------------
+inline CXX11_PRINTF_CONSTEXPR size_t escaped_length(const char *p, size_t n, bool c_style) noexcept {
+
+	char   seq[8];
+	size_t len = 0;
+
+	while (true) {
+		const size_t run = escape_scan(p, n, c_style);
+		len += run;
+		if (run == n) {
+			return len;
+		}
+
+		len += escape_char(seq, static_cast<unsigned char>(p[run]), c_style);
+		p += run + 1;
+		n -= run + 1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: output_escaped
+// Desc: prints n chars to the Context, escaped for JSON or with the '#' flag
+//       for C, taking into account padding flags. Runs of chars which need no
+//       escaping are written with a single write
+//------------------------------------------------------------------------------
+template <class Context>
+CXX11_PRINTF_CONSTEXPR void output_escaped(const char *p, size_t n, long int width, Flags flags, Context &ctx) CXX11_PRINTF_NOEXCEPT {
+
+	const bool c_style = flags.prefix;
+
+	// NOTE(eteran): escaping never shortens the string, so the escaped length
+	//               is only needed when the width might require padding
+	long int pad = 0;
+	if (width > static_cast<long int>(n)) {
+		pad = width - static_cast<long int>(escaped_length(p, n, c_style));
+	}
+
+	// if not left justified padding goes first...
+	if (!flags.justify) {
+		while (pad-- > 0) {
+			ctx.write(' ');
+		}
+	}
+
+	char seq[8];
+	while (true) {
+		const size_t run = escape_scan(p, n, c_style);
+		if (run != 0) {
+			write_chars(ctx, p, run);
+		}
+
+		if (run == n) {
+			break;
+		}
+
+		write_chars(ctx, seq, escape_char(seq, static_cast<unsigned char>(p[run]), c_style));
+		p += run + 1;
+		n -= run + 1;
+	}
+
+	// if left justified padding goes last...
+	if (flags.justify) {
+		while (pad-- > 0) {
+			ctx.write(' ');
+		}
+	}
+}
+#endif
+
+// NOTE(eteran): Here is some code to fetch arguments of specific types. We also need a few
+//               default handlers, this code should never really be encountered, but
+//               but we need it to keep the linker happy.
+
 //------------------------------------------------------------------------------
+// Name: raise
+// Desc: reports an error with an argument. With exceptions enabled, this throws.
+//       Otherwise, the error is recorded in err and a placeholder is returned
+//------------------------------------------------------------------------------
+template <class R>
+CXX11_PRINTF_CONSTEXPR R raise(format_errc &err, format_errc code) CXX11_PRINTF_NOEXCEPT {
+#ifdef CXX11_PRINTF_NO_EXCEPTIONS
+	err = code;
+	return R();
+#else
+	(void)err;
+	throw format_error(code);
+#endif
+}
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+// NOTE(eteran): the fallback to_string returns a distinct type so that we can
+//               tell at compile time that no real to_string was found
+struct missing_to_string {};
+
+template <class T>
+missing_to_string to_string(T) {
+	return missing_to_string();
+}
+
+inline std::string object_string(std::string s, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return s;
+}
+
+inline std::string object_string(missing_to_string, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	return raise<std::string>(err, format_errc::no_to_string);
+}
+
+inline std::string formatted_object(std::string obj, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return obj;
+}
+
+template <class T>
+std::string formatted_object(T obj, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	using std::to_string;
+	using detail::to_string;
+	return object_string(to_string(obj), err);
+}
+#endif
+
+template <class R, class T>
+CXX11_PRINTF_CONSTEXPR R formatted_string(T s, format_errc &err, typename std::enable_if<std::is_convertible<T, R>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return s;
+}
+
+template <class R, class T>
+CXX11_PRINTF_CONSTEXPR R formatted_string(T s, format_errc &err, typename std::enable_if<!std::is_convertible<T, R>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)s;
+	return raise<R>(err, format_errc::non_string_argument);
+}
+
+// NOTE(eteran): the character type of a string argument to %ls, which may be
+//               any. Anything else is treated as a char string, and rejected
+template <class T>
+struct string_char {
+	typedef typename std::conditional<std::is_convertible<T, const wchar_t *>::value && !std::is_convertible<T, const char *>::value, wchar_t,
+		typename std::conditional<std::is_convertible<T, const char16_t *>::value && !std::is_convertible<T, const char *>::value, char16_t,
+			typename std::conditional<std::is_convertible<T, const char32_t *>::value && !std::is_convertible<T, const char *>::value, char32_t,
+				char>::type>::type>::type type;
+};
+
+template <class Ch>
+struct null_string {
+	static constexpr Ch value[] = {'(', 'n', 'u', 'l', 'l', ')', '\0'};
+};
+
+template <class Ch>
+constexpr Ch null_string<Ch>::value[];
+
+template <class R, class T>
+CXX11_PRINTF_CONSTEXPR R formatted_pointer(T p, format_errc &err, typename std::enable_if<std::is_convertible<T, const void *>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return reinterpret_cast<R>(reinterpret_cast<uintptr_t>(p));
+}
+
+template <class R, class T>
+CXX11_PRINTF_CONSTEXPR R formatted_pointer(T p, format_errc &err, typename std::enable_if<!std::is_convertible<T, const void *>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)p;
+	return raise<R>(err, format_errc::non_pointer_argument);
+}
+
+template <class R, class T>
+CXX11_PRINTF_CONSTEXPR R formatted_integer(T n, format_errc &err, typename std::enable_if<std::is_integral<T>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return static_cast<R>(n);
+}
+
+template <class R, class T>
+CXX11_PRINTF_CONSTEXPR R formatted_integer(T n, format_errc &err, typename std::enable_if<!std::is_integral<T>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)n;
+	return raise<R>(err, format_errc::non_integer_argument);
+}
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+// NOTE(eteran): a point in time as whole seconds since the epoch and a
+//               nanosecond fraction which is always in [0, 1e9)
+struct timestamp {
+	int64_t seconds;
+	long    nanoseconds;
+};
+
+template <class Duration>
+timestamp formatted_timestamp(const std::chrono::time_point<std::chrono::system_clock, Duration> &tp, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	const int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+	timestamp ts     = {ns / 1000000000, static_cast<long>(ns % 1000000000)};
+	if (ts.nanoseconds < 0) {
+		ts.nanoseconds += 1000000000;
+		--ts.seconds;
+	}
+	return ts;
+}
+
+inline timestamp formatted_timestamp(const timespec &t, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return timestamp{static_cast<int64_t>(t.tv_sec), static_cast<long>(t.tv_nsec)};
+}
+
+template <class T>
+timestamp formatted_timestamp(const T &t, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	(void)t;
+	return raise<timestamp>(err, format_errc::non_time_argument);
+}
+
+// NOTE(eteran): nearly every timestamp printed shares its date, hour and minute
+//               with the previous one printed by the same thread. So we keep the
+//               rendered "YYYY-MM-DDTHH:MM:" prefix and time zone suffix of the
+//               last minute seen, and only render the seconds and fraction
+struct timestamp_cache {
+	int64_t minute = std::numeric_limits<int64_t>::min();
+	char    prefix[32];
+	char    zone[8];
+	size_t  prefix_len = 0;
+	size_t  zone_len   = 0;
+};
+
+inline char *write_digits(char *p, unsigned int value, int digits) noexcept {
+	for (int i = digits - 1; i >= 0; --i) {
+		p[i] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	}
+	return p + digits;
+}
+
+//------------------------------------------------------------------------------
+// Name: render_minute
+// Desc: renders the prefix and time zone suffix of the minute starting at
+//       seconds into the cache, in UTC or in local time
+//------------------------------------------------------------------------------
+inline void render_minute(timestamp_cache &cache, int64_t seconds, bool local) noexcept {
+
+	int64_t  days;
+	unsigned hour;
+	unsigned minute;
+	long     offset = 0;
+
+	if (local) {
+		const time_t t = static_cast<time_t>(seconds);
+		struct tm tm;
+#ifdef _WIN32
+		localtime_s(&tm, &t);
+		offset = static_cast<long>(_mkgmtime(&tm) - t);
+#else
+		localtime_r(&t, &tm);
+		offset = tm.tm_gmtoff;
+#endif
+		seconds += offset;
+	}
+
+	// NOTE(eteran): floor division, so that times before the epoch work
+	days = seconds / 86400;
+	if (seconds % 86400 < 0) {
+		--days;
+	}
+
+	const int64_t secs = seconds - days * 86400;
+	hour               = static_cast<unsigned>(secs / 3600);
+	minute             = static_cast<unsigned>(secs % 3600 / 60);
+
+	// NOTE(eteran): civil_from_days from Howard Hinnant's date algorithms,
+	//               converts days since the epoch to a proleptic Gregorian date
+	const int64_t  z   = days + 719468;
+	const int64_t  era = (z >= 0 ? z : z - 146096) / 146097;
+	const unsigned doe = static_cast<unsigned>(z - era * 146097);
+	const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	const unsigned mp  = (5 * doy + 2) / 153;
+	const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+	const unsigned mon = mp < 10 ? mp + 3 : mp - 9;
+	const int64_t  year = yoe + era * 400 + (mon <= 2);
+
+	char *p = cache.prefix;
+	if (year < 0 || year > 9999) {
+		// NOTE(eteran): ISO-8601 expanded years, always signed
+		*p++ = (year < 0) ? '-' : '+';
+		const uint64_t y = (year < 0) ? 0 - static_cast<uint64_t>(year) : static_cast<uint64_t>(year);
+		int digits = 4;
+		for (uint64_t n = y / 10000; n != 0; n /= 10) {
+			++digits;
+		}
+		char *end = p + digits;
+		uint64_t n = y;
+		while (end != p) {
+			*--end = static_cast<char>('0' + n % 10);
+			n /= 10;
+		}
+		p += digits;
+	} else {
+		p = write_digits(p, static_cast<unsigned>(year), 4);
+	}
+	*p++ = '-';
+	p = write_digits(p, mon, 2);
+	*p++ = '-';
+	p = write_digits(p, day, 2);
+	*p++ = 'T';
+	p = write_digits(p, hour, 2);
+	*p++ = ':';
+	p = write_digits(p, minute, 2);
+	*p++ = ':';
+	cache.prefix_len = p - cache.prefix;
+
+	p = cache.zone;
+	if (!local) {
+		*p++ = 'Z';
+	} else {
+		*p++ = (offset < 0) ? '-' : '+';
+		const unsigned long abs_offset = (offset < 0) ? -offset : offset;
+		p = write_digits(p, static_cast<unsigned>(abs_offset / 3600), 2);
+		*p++ = ':';
+		p = write_digits(p, static_cast<unsigned>(abs_offset % 3600 / 60), 2);
+	}
+	cache.zone_len = p - cache.zone;
+}
+
+//------------------------------------------------------------------------------
+// Name: format_timestamp
+// Desc: returns ts as an ISO-8601 C-string with precision fractional digits of
+//       seconds, in UTC or, with the '#' flag, in local time with its offset.
+//       places the length of the resultant string in *rlen
+//------------------------------------------------------------------------------
+template <size_t N>
+const char *format_timestamp(char (&buf)[N], timestamp ts, int precision, Flags flags, size_t *rlen) noexcept {
+
+	static_assert(N >= 64, "buffer too small for a timestamp");
+
+	// NOTE(eteran): milliseconds by default, nanoseconds at most
+	if (precision < 0) {
+		precision = 3;
+	} else if (precision > 9) {
+		precision = 9;
+	}
+
+	int64_t minute = ts.seconds / 60;
+	if (ts.seconds % 60 < 0) {
+		--minute;
+	}
+
+	static thread_local timestamp_cache caches[2];
+	timestamp_cache &cache = caches[flags.prefix];
+
+	if (cache.minute != minute) {
+		render_minute(cache, minute * 60, flags.prefix);
+		cache.minute = minute;
+	}
+
+	char *p = buf;
+	memcpy(p, cache.prefix, cache.prefix_len);
+	p += cache.prefix_len;
+	p = write_digits(p, static_cast<unsigned>(ts.seconds - minute * 60), 2);
+
+	if (precision > 0) {
+		static const unsigned int divisors[] = {1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1};
+		*p++ = '.';
+		p = write_digits(p, static_cast<unsigned>(ts.nanoseconds) / divisors[precision], precision);
+	}
+
+	memcpy(p, cache.zone, cache.zone_len);
+	p += cache.zone_len;
+	*p = '\0';
+
+	*rlen = p - buf;
+	return buf;
+}
+
+//------------------------------------------------------------------------------
+// Name: fixed_magnitude
+// Desc: splits an integer argument into its sign and magnitude, so that both
+//       INTMAX_MIN and UINTMAX_MAX are exact
+//------------------------------------------------------------------------------
+template <class T>
+CXX11_PRINTF_CONSTEXPR uintmax_t fixed_magnitude(T n, bool &negative, format_errc &err, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	negative = (n < 0);
+
+	// NOTE(eteran): negate as unsigned, -INTMAX_MIN is not representable
+	return negative ? 0 - static_cast<uintmax_t>(n) : static_cast<uintmax_t>(n);
+}
+
+template <class T>
+CXX11_PRINTF_CONSTEXPR uintmax_t fixed_magnitude(T n, bool &negative, format_errc &err, typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	negative = false;
+	return static_cast<uintmax_t>(n);
+}
+
+template <class T>
+CXX11_PRINTF_CONSTEXPR uintmax_t fixed_magnitude(T n, bool &negative, format_errc &err, typename std::enable_if<!std::is_integral<T>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)n;
+	negative = false;
+	return raise<uintmax_t>(err, format_errc::non_integer_argument);
+}
+
+//------------------------------------------------------------------------------
+// Name: output_fixed
+// Desc: prints ud / 10^scale, negated if requested, to the Context as an exact
+//       decimal with precision fractional digits, rounding half away from zero.
+//       A negative scale multiplies instead. Nothing is printed if there was an
+//       error getting the argument
+//------------------------------------------------------------------------------
+template <class Context>
+CXX11_PRINTF_CONSTEXPR void output_fixed(Context &ctx, bool negative, uintmax_t ud, long int scale, long int precision, long int width, Flags flags, Grouping grouping, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	if (err != format_errc::none) {
+		return;
+	}
+
+	// the precision defaults to the scale
+	if (precision < 0) {
+		precision = (scale > 0) ? scale : 0;
+	}
+
+	// a negative scale is exact as long as the product fits
+	if (scale < 0) {
+		for (; scale < 0 && ud != 0; ++scale) {
+			if (ud > std::numeric_limits<uintmax_t>::max() / 10) {
+				raise<void>(err, format_errc::scale_out_of_range);
+				return;
+			}
+			ud *= 10;
+		}
+		scale = 0;
+	}
+
+	// drop the digits we don't want, rounding half away from zero
+	if (precision < scale) {
+		const long int drop = scale - precision;
+		if (drop < std::numeric_limits<uintmax_t>::digits10 + 1) {
+			uintmax_t pow = 1;
+			for (long int i = 0; i < drop; ++i) {
+				pow *= 10;
+			}
+
+			const uintmax_t r = ud % pow;
+			ud /= pow;
+			if (r >= pow - r) {
+				++ud;
+			}
+		} else {
+			// NOTE(eteran): 10^20 is more than twice any 64-bit value
+			ud = 0;
+		}
+		scale = precision;
+	}
+
+	// NOTE(eteran): ud has at most 20 digits, so with a larger scale the rest of
+	//               the fraction is leading zeros, which are never stored
+	char fraction[20];
+	char *const fraction_end = fraction + sizeof(fraction);
+	char *f = fraction_end;
+	for (long int i = 0; i < scale && f != fraction; ++i) {
+		*--f = alphabet_l[ud % 10];
+		ud /= 10;
+	}
+
+	// enough for 20 digits, each of which may be grouped
+	char integer[40];
+	char *const integer_end = integer + sizeof(integer);
+	const char *p = itoa_helper<10>::generate(integer_end, ud, flags, grouping, alphabet_l);
+
+	char prefix[1];
+	const size_t prefix_len = itoa_helper<10>::prefix(prefix, negative, flags, alphabet_l);
+
+	// like %#.0f, the '#' flag keeps the decimal point
+	const bool   point   = (precision > 0 || flags.prefix);
+	const size_t int_len = integer_end - p;
+	const size_t stored  = fraction_end - f;
+	const size_t leading = scale - stored;
+	const size_t zeros   = precision - scale;
+
+	const number_layout layout(width, prefix_len, int_len + point + leading + stored + zeros, flags);
+
+	if (!flags.justify) {
+		write_repeated(ctx, ' ', layout.spaces);
+	}
+
+	write_chars(ctx, prefix, prefix_len);
+	write_repeated(ctx, '0', layout.zeros);
+	write_chars(ctx, p, int_len);
+
+	if (point) {
+		ctx.write('.');
+	}
+
+	write_repeated(ctx, '0', leading);
+	write_chars(ctx, f, stored);
+	write_repeated(ctx, '0', zeros);
+
+	if (flags.justify) {
+		write_repeated(ctx, ' ', layout.spaces);
+	}
+}
+
+// NOTE(eteran): floats are formatted as floats, so that they get their own
+//               shortest representation. Anything wider is formatted as a double
+template <class T>
+CXX11_PRINTF_CONSTEXPR size_t formatted_shortest(char *buf, T v, format_errc &err, typename std::enable_if<std::is_same<T, float>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return shortest::format(buf, v);
+}
+
+template <class T>
+CXX11_PRINTF_CONSTEXPR size_t formatted_shortest(char *buf, T v, format_errc &err, typename std::enable_if<std::is_floating_point<T>::value && !std::is_same<T, float>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return shortest::format(buf, static_cast<double>(v));
+}
+
+template <class T>
+CXX11_PRINTF_CONSTEXPR size_t formatted_shortest(char *buf, T v, format_errc &err, typename std::enable_if<!std::is_floating_point<T>::value>::type * = 0) CXX11_PRINTF_NOEXCEPT {
+	(void)v;
+	// NOTE(eteran): without exceptions we return here, so leave buf initialized
+	*buf = '\0';
+	return raise<size_t>(err, format_errc::non_float_argument);
+}
+
+inline bytes formatted_bytes(const bytes &b, format_errc &err, int) CXX11_PRINTF_NOEXCEPT {
+	(void)err;
+	return b;
+}
+
+// NOTE(eteran): anything contiguous, such as std::string, std::vector or std::array
+template <class T>
+auto formatted_bytes(const T &c, format_errc &err, int) CXX11_PRINTF_NOEXCEPT -> decltype(bytes(c.data(), c.size() * sizeof(*c.data()))) {
+	(void)err;
+	return bytes(c.data(), c.size() * sizeof(*c.data()));
+}
+
+template <class T>
+bytes formatted_bytes(const T &b, format_errc &err, long) CXX11_PRINTF_NOEXCEPT {
+	(void)b;
+	return raise<bytes>(err, format_errc::non_bytes_argument);
+}
+#endif
+
+// NOTE(eteran): a context may optionally have a start() member, which is called
+//               at the beginning of every Printf. Contexts which are reused for
+//               many calls use it to count the chars written by each call alone
 template <class Context>
-int get_precision(Context &ctx, const char *format, Flags flags, long int width) {
+CXX11_PRINTF_CONSTEXPR auto start_call(Context &ctx, int) CXX11_PRINTF_NOEXCEPT -> decltype(ctx.start(), void()) {
+	ctx.start();
+}
+
+template <class Context>
+CXX11_PRINTF_CONSTEXPR void start_call(Context &, long) CXX11_PRINTF_NOEXCEPT {
+}
+
+// NOTE(eteran): a context may optionally have an "error" member, which will be
+//               set to the first error encountered when exceptions are disabled
+template <class Context>
+CXX11_PRINTF_CONSTEXPR auto set_error(Context &ctx, format_errc code, int) CXX11_PRINTF_NOEXCEPT -> decltype(ctx.error = code, void()) {
+	if (ctx.error == format_errc::none) {
+		ctx.error = code;
+	}
+}
+
+template <class Context>
+CXX11_PRINTF_CONSTEXPR void set_error(Context &, format_errc, long) CXX11_PRINTF_NOEXCEPT {
+}
+
+//------------------------------------------------------------------------------
+// Name: fail
+// Desc: reports an error in the format itself, formatting can not continue
+//------------------------------------------------------------------------------
+template <class Context>
+CXX11_PRINTF_CONSTEXPR int fail(Context &ctx, format_errc code) CXX11_PRINTF_NOEXCEPT {
+#ifdef CXX11_PRINTF_NO_EXCEPTIONS
+	set_error(ctx, code, 0);
+	ctx.done();
+	return -1;
+#else
 	(void)ctx;
-	(void)format;
-	(void)flags;
-	(void)width;
-	throw format_error("Should Never Happen");
+	throw format_error(code);
+#endif
+}
+
+template <class Context, class CharT>
+CXX11_PRINTF_CONSTEXPR int printf_sequential(Context &ctx, const CharT *format) CXX11_PRINTF_NOEXCEPT;
+
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int printf_sequential(Context &ctx, const CharT *format, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT;
+
+//------------------------------------------------------------------------------
+// Name: fail_argument
+// Desc: reports an error converting an argument. Unless CXX11_PRINTF_STOP_ON_ERROR
+//       is defined, the conversion is skipped and formatting continues with the
+//       rest of the format, but the result will still be -1
+//------------------------------------------------------------------------------
+#if defined(CXX11_PRINTF_NO_EXCEPTIONS) && !defined(CXX11_PRINTF_STOP_ON_ERROR)
+template <class Context, class CharT, class... Ts>
+CXX11_PRINTF_CONSTEXPR int fail_argument(Context &ctx, format_errc code, const CharT *format, const Ts &... ts) noexcept {
+	set_error(ctx, code, 0);
+	printf_sequential(ctx, format, ts...);
+	return -1;
 }
+#else
+template <class Context, class CharT, class... Ts>
+CXX11_PRINTF_CONSTEXPR int fail_argument(Context &ctx, format_errc code, const CharT *, const Ts &...) CXX11_PRINTF_NOEXCEPT {
+	return fail(ctx, code);
+}
+#endif
 
 //------------------------------------------------------------------------------
-// Name: process_format
-// Desc: prints the next argument to the Context taking into account the flags,
-//       width, precision, and modifiers collected along the way. Then will
-//       recursively continue processing the string
+// Name: format_argument
+// Desc: prints a single argument to the Context taking into account the flags,
+//       width, precision, scale and modifiers. Returns true if the argument was
+//       consumed by the conversion, false if ch is not a known conversion.
+//       Errors with the argument are reported in err
 //------------------------------------------------------------------------------
-template <class Context, class T, class... Ts>
-int process_format(Context &ctx, const char *format, Flags flags, long int width, long int precision, Modifiers modifier, const T &arg, const Ts &... ts) {
+template <class Context, class CharT, class T>
+CXX11_PRINTF_CONSTEXPR bool format_argument(Context &ctx, CharT ch, Flags flags, long int width, long int precision, long int scale, Modifiers modifier, const T &arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
 
-	// enough to contain a 64-bit number in bin notation + optional prefix
-	char num_buf[67];
+	typedef typename context_char<Context>::type char_type;
+
+	// enough to contain a 64-bit number in bin notation + optional prefix,
+	// or a grouped fixed point number
+	char num_buf[80];
 
 	size_t slen;
 	const char *s_ptr = nullptr;
 
-	char ch = *format;
+	const Grouping grouping = get_grouping(ctx, 0);
+
+#ifdef CXX11_PRINTF_INSTRUMENT
+	const instrument::conversion_probe<Context> probe(ctx, ch);
+#endif
+
 	switch (ch) {
 	case 'e':
 	case 'E':
@@ -455,17 +1740,14 @@ int process_format(Context &ctx, const char *format, Flags flags, long int width
 	case 'g':
 	case 'G':
 		// TODO(eteran): implement float formatting... for now, just consume the argument
-		return Printf(ctx, format + 1, ts...);
+		return true;
 
 	case 'p':
 		precision = 1;
 		ch = 'x';
 		flags.prefix = 1;
 		// NOTE(eteran): GNU printf prints "(nil)" for NULL pointers, we print 0x0
-		s_ptr = itoa(num_buf, ch, precision, formatted_pointer<uintptr_t>(arg), width, flags, &slen);
-
-		output_string(ch, s_ptr, precision, width, flags, slen, ctx);
-		return Printf(ctx, format + 1, ts...);
+		return output_integer(ctx, ch, precision, formatted_pointer<uintptr_t>(arg, err), width, flags, grouping, err);
 
 	case 'x':
 	case 'X':
@@ -480,34 +1762,23 @@ int process_format(Context &ctx, const char *format, Flags flags, long int width
 
 		switch (modifier) {
 		case Modifiers::MOD_CHAR:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<unsigned char>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<unsigned char>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_SHORT:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<unsigned short int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<unsigned short int>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_LONG:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<unsigned long int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<unsigned long int>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_LONG_LONG:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<unsigned long long int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<unsigned long long int>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_INTMAX_T:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<uintmax_t>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<uintmax_t>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_SIZE_T:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<size_t>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<size_t>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_PTRDIFF_T:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<std::make_unsigned<ptrdiff_t>::type>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<std::make_unsigned<ptrdiff_t>::type>(arg, err), width, flags, grouping, err);
 		default:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<unsigned int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<unsigned int>(arg, err), width, flags, grouping, err);
 		}
 
-		output_string(ch, s_ptr, precision, width, flags, slen, ctx);
-		return Printf(ctx, format + 1, ts...);
-
 	case 'i':
 	case 'd':
 		if (precision < 0) {
@@ -516,98 +1787,494 @@ int process_format(Context &ctx, const char *format, Flags flags, long int width
 
 		switch (modifier) {
 		case Modifiers::MOD_CHAR:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<signed char>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<signed char>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_SHORT:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<short int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<short int>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_LONG:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<long int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<long int>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_LONG_LONG:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<long long int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<long long int>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_INTMAX_T:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<intmax_t>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<intmax_t>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_SIZE_T:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<std::make_signed<size_t>::type>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<std::make_signed<size_t>::type>(arg, err), width, flags, grouping, err);
 		case Modifiers::MOD_PTRDIFF_T:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<ptrdiff_t>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<ptrdiff_t>(arg, err), width, flags, grouping, err);
 		default:
-			s_ptr = itoa(num_buf, ch, precision, formatted_integer<int>(arg), width, flags, &slen);
-			break;
+			return output_integer(ctx, ch, precision, formatted_integer<int>(arg, err), width, flags, grouping, err);
+		}
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+	case 'T': // extension, ISO-8601 TIMESTAMP mode
+		s_ptr = format_timestamp(num_buf, formatted_timestamp(arg, err), precision, flags, &slen);
+		if (err != format_errc::none) {
+			return true;
 		}
 
 		output_string(ch, s_ptr, precision, width, flags, slen, ctx);
-		return Printf(ctx, format + 1, ts...);
+		return true;
 
-	case 'c':
-		// char is promoted to an int when pushed on the stack
-		num_buf[0] = formatted_integer<char>(arg);
-		num_buf[1] = '\0';
-		s_ptr = num_buf;
-		output_string('c', s_ptr, precision, width, flags, 1, ctx);
-		return Printf(ctx, format + 1, ts...);
+	case 'y': // extension, HEX DUMP mode
+	case 'Y': {
+		const bytes b = formatted_bytes(arg, err, 0);
+		if (err != format_errc::none) {
+			return true;
+		}
+
+		// NOTE(eteran): the precision caps the number of bytes printed
+		size_t n = b.size;
+		if (precision >= 0 && static_cast<size_t>(precision) < n) {
+			n = precision;
+		}
+
+		output_hex(static_cast<const uint8_t *>(b.data), n, width, flags, (ch == 'Y') ? alphabet_u : alphabet_l, ctx);
+	}
+		return true;
+
+	case 'J': { // extension, ESCAPED STRING mode
+		s_ptr = formatted_string<const char *>(arg, err);
+		if (err != format_errc::none) {
+			return true;
+		}
 
-	case 's':
-		s_ptr = formatted_string(arg);
 		if (!s_ptr) {
 			s_ptr = "(null)";
 		}
-		output_string('s', s_ptr, precision, width, flags, strlen(s_ptr), ctx);
-		return Printf(ctx, format + 1, ts...);
+
+		// NOTE(eteran): like %s, the precision limits how much of the source is read
+		size_t n;
+		if (precision >= 0) {
+			const char *end = find_char(s_ptr, '\0', precision);
+			n = end ? end - s_ptr : precision;
+		} else {
+			n = string_length(s_ptr);
+		}
+
+		output_escaped(s_ptr, n, width, flags, ctx);
+	}
+		return true;
+
+	case 'r': { // extension, SHORTEST ROUND TRIP mode
+		// NOTE(eteran): leave room for a sign
+		char *p    = num_buf + 1;
+		size_t len = formatted_shortest(p, arg, err);
+		if (err != format_errc::none) {
+			return true;
+		}
+
+		if (*p != '-') {
+			if (flags.sign) {
+				*--p = '+';
+				++len;
+			} else if (flags.space) {
+				*--p = ' ';
+				++len;
+			}
+		}
+
+		// zeros go between the sign and the digits, but never pad inf or nan
+		if (flags.padding && width > static_cast<long int>(len) && p[len - 1] >= '0' && p[len - 1] <= '9') {
+			const size_t sign = (*p == '-' || *p == '+' || *p == ' ');
+			write_chars(ctx, p, sign);
+			for (long int i = len; i < width; ++i) {
+				ctx.write('0');
+			}
+			write_chars(ctx, p + sign, len - sign);
+			return true;
+		}
+
+		output_string(ch, p, precision, width, flags, len, ctx);
+	}
+		return true;
+
+	case 'k': // extension, FIXED POINT mode
+	{
+		bool            negative = false;
+		const uintmax_t ud       = fixed_magnitude(arg, negative, err);
+		output_fixed(ctx, negative, ud, scale, precision, width, flags, grouping, err);
+	}
+		return true;
+#endif
+
+	case 'c':
+		if (modifier == Modifiers::MOD_LONG) {
+			// NOTE(eteran): %lc takes a character of any type, as a code point
+			char32_t cp = formatted_integer<char32_t>(arg, err);
+			if (err != format_errc::none) {
+				return true;
+			}
+
+			if (!unicode::is_valid(cp)) {
+				cp = unicode::replacement;
+			}
+
+			char_type units[4];
+			output_string('c', units, precision, width, flags, static_cast<int>(unicode::encode(cp, units)), ctx);
+			return true;
+		} else {
+			// char is promoted to an int when pushed on the stack
+			const char_type c = formatted_integer<char_type>(arg, err);
+			if (err != format_errc::none) {
+				return true;
+			}
+
+			output_string('c', &c, precision, width, flags, 1, ctx);
+			return true;
+		}
+
+	case 's':
+		if (modifier == Modifiers::MOD_LONG) {
+			// NOTE(eteran): %ls takes a string of any character type, which is
+			//               transcoded if it isn't the Context's
+			typedef typename string_char<T>::type source_type;
+
+			const source_type *w_ptr = formatted_string<const source_type *>(arg, err);
+			if (err != format_errc::none) {
+				return true;
+			}
+
+			if (!w_ptr) {
+				w_ptr = null_string<source_type>::value;
+			}
+			output_string('s', w_ptr, precision, width, flags, string_length(w_ptr), ctx);
+			return true;
+		} else {
+			const char_type *c_ptr = formatted_string<const char_type *>(arg, err);
+			if (err != format_errc::none) {
+				return true;
+			}
+
+			if (!c_ptr) {
+				c_ptr = null_string<char_type>::value;
+			}
+			output_string('s', c_ptr, precision, width, flags, string_length(c_ptr), ctx);
+			return true;
+		}
 
 #ifdef CXX11_PRINTF_EXTENSIONS
 	case '?': {
-		std::string s = formatted_object(arg);
+		std::string s = formatted_object(arg, err);
+		if (err != format_errc::none) {
+			return true;
+		}
+#ifdef CXX11_PRINTF_INSTRUMENT
+		instrument::record_object(s);
+#endif
 		output_string('s', s.data(), precision, width, flags, s.size(), ctx);
 	}
-		return Printf(ctx, format + 1, ts...);
+		return true;
 #endif
 
 	case 'n':
+		// NOTE(eteran): check the type up front, so we never write through a bad pointer
+		formatted_pointer<void *>(arg, err);
+		if (err != format_errc::none) {
+			return true;
+		}
+
 		switch (modifier) {
 		case Modifiers::MOD_CHAR:
-			*formatted_pointer<signed char *>(arg) = ctx.written;
+			*formatted_pointer<signed char *>(arg, err) = ctx.written;
 			break;
 		case Modifiers::MOD_SHORT:
-			*formatted_pointer<short int *>(arg) = ctx.written;
+			*formatted_pointer<short int *>(arg, err) = ctx.written;
 			break;
 		case Modifiers::MOD_LONG:
-			*formatted_pointer<long int *>(arg) = ctx.written;
+			*formatted_pointer<long int *>(arg, err) = ctx.written;
 			break;
 		case Modifiers::MOD_LONG_LONG:
-			*formatted_pointer<long long int *>(arg) = ctx.written;
+			*formatted_pointer<long long int *>(arg, err) = ctx.written;
 			break;
 		case Modifiers::MOD_INTMAX_T:
-			*formatted_pointer<intmax_t *>(arg) = ctx.written;
+			*formatted_pointer<intmax_t *>(arg, err) = ctx.written;
 			break;
 		case Modifiers::MOD_SIZE_T:
-			*formatted_pointer<std::make_signed<size_t>::type *>(arg) = ctx.written;
+			*formatted_pointer<std::make_signed<size_t>::type *>(arg, err) = ctx.written;
 			break;
 		case Modifiers::MOD_PTRDIFF_T:
-			*formatted_pointer<ptrdiff_t *>(arg) = ctx.written;
+			*formatted_pointer<ptrdiff_t *>(arg, err) = ctx.written;
 			break;
 		default:
-			*formatted_pointer<int *>(arg) = ctx.written;
+			*formatted_pointer<int *>(arg, err) = ctx.written;
+			break;
+		}
+
+		return true;
+
+	default:
+		ctx.write('%');
+		ctx.write(ch);
+		return false;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: is_positional
+// Desc: returns true if format (just past the '%') begins with a POSIX "n$"
+//       argument index
+//------------------------------------------------------------------------------
+template <class CharT>
+inline CXX11_PRINTF_CONSTEXPR bool is_positional(const CharT *format) noexcept {
+
+	if (*format < '1' || *format > '9') {
+		return false;
+	}
+
+	while (*format >= '0' && *format <= '9') {
+		++format;
+	}
+
+	return *format == '$';
+}
+
+//------------------------------------------------------------------------------
+// Name: argument_width
+// Desc: like printf, a negative width taken from an argument is read as the '-'
+//       flag followed by a positive width
+//------------------------------------------------------------------------------
+inline CXX11_PRINTF_CONSTEXPR long int argument_width(long int width, Flags &flags) noexcept {
+
+	if (width >= 0) {
+		return width;
+	}
+
+	flags.justify = 1;
+	flags.padding = 0;
+
+	// NOTE(eteran): -LONG_MIN is not representable
+	return (width < -std::numeric_limits<long int>::max()) ? std::numeric_limits<long int>::max() : -width;
+}
+
+//------------------------------------------------------------------------------
+// Name: write_literal
+// Desc: writes the text of format up to its next conversion, collapsing "%%"
+//       as it goes. Returns a pointer to the '%' of that conversion, or to the
+//       terminating NUL if there is none
+//------------------------------------------------------------------------------
+template <class Context, class CharT>
+inline CXX11_PRINTF_CONSTEXPR const CharT *write_literal(Context &ctx, const CharT *format) {
+
+	while (*format != '\0') {
+		if (*format == '%') {
+			if (format[1] != '%') {
+				break;
+			}
+
+			++format;
+		}
+
+		ctx.write(*format++);
+	}
+
+	return format;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_flags
+// Desc: gets the flags, if any, from the format string
+//------------------------------------------------------------------------------
+template <class CharT>
+inline CXX11_PRINTF_CONSTEXPR Flags parse_flags(const CharT *&format) noexcept {
+
+	Flags f = {0, 0, 0, 0, 0, 0, 0};
+
+	while (true) {
+		switch (*format) {
+		case '-':
+			// justify, overrides padding
+			f.justify = 1;
+			f.padding = 0;
+			break;
+		case '+':
+			// sign, overrides space
+			f.sign = 1;
+			f.space = 0;
+			break;
+		case ' ':
+			if (!f.sign) {
+				f.space = 1;
+			}
+			break;
+		case '#':
+			f.prefix = 1;
+			break;
+		case '\'':
+			f.grouping = 1;
+			break;
+		case '0':
+			if (!f.justify) {
+				f.padding = 1;
+			}
 			break;
+		default:
+			return f;
+		}
+
+		++format;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_modifier
+// Desc: gets the modifier, if any, from the format string
+//------------------------------------------------------------------------------
+template <class CharT>
+inline CXX11_PRINTF_CONSTEXPR Modifiers parse_modifier(const CharT *&format) noexcept {
+
+	Modifiers modifier = Modifiers::MOD_NONE;
+
+	switch (*format) {
+	case 'h':
+		modifier = Modifiers::MOD_SHORT;
+		++format;
+		if (*format == 'h') {
+			modifier = Modifiers::MOD_CHAR;
+			++format;
+		}
+		break;
+	case 'l':
+		modifier = Modifiers::MOD_LONG;
+		++format;
+		if (*format == 'l') {
+			modifier = Modifiers::MOD_LONG_LONG;
+			++format;
+		}
+		break;
+	case 'L':
+		modifier = Modifiers::MOD_LONG_DOUBLE;
+		++format;
+		break;
+	case 'j':
+		modifier = Modifiers::MOD_INTMAX_T;
+		++format;
+		break;
+	case 'z':
+		modifier = Modifiers::MOD_SIZE_T;
+		++format;
+		break;
+	case 't':
+		modifier = Modifiers::MOD_PTRDIFF_T;
+		++format;
+		break;
+	default:
+		break;
+	}
+
+	return modifier;
+}
+
+//------------------------------------------------------------------------------
+// Name: printf_sequential
+// Desc: 0 argument version of printf_sequential. Fails on any conversion
+//       found, as there is nothing left to convert
+//------------------------------------------------------------------------------
+template <class Context, class CharT>
+CXX11_PRINTF_CONSTEXPR int printf_sequential(Context &ctx, const CharT *format) CXX11_PRINTF_NOEXCEPT {
+
+	format = write_literal(ctx, format);
+	if (*format != '\0') {
+		// NOTE(eteran): "%n$" after a sequential conversion is out of arguments
+		//               too, but mixing the two is the actual mistake
+		const CharT *spec = format + 1;
+		if (is_positional(spec)) {
+			return fail(ctx, format_errc::mixed_positional);
+		}
+
+		parse_flags(spec);
+		if (*spec == '*' && is_positional(spec + 1)) {
+			return fail(ctx, format_errc::mixed_positional);
 		}
 
-		return Printf(ctx, format + 1, ts...);
+		return fail(ctx, format_errc::bad_format);
+	}
+
+	// this will usually null terminate the string
+	ctx.done();
+
+	// return the amount of bytes that should have been written if there was sufficient space
+	return ctx.written;
+}
+
+//------------------------------------------------------------------------------
+// Name: process_format
+// Desc: default handler, only reached when there are too few arguments
+//------------------------------------------------------------------------------
+template <class Context, class CharT>
+CXX11_PRINTF_CONSTEXPR int process_format(Context &ctx, const CharT *format, Flags flags, long int width, long int precision, long int scale, Modifiers modifier) CXX11_PRINTF_NOEXCEPT {
+	(void)format;
+	(void)flags;
+	(void)width;
+	(void)precision;
+	(void)scale;
+	(void)modifier;
+	return fail(ctx, format_errc::bad_format);
+}
+
+//------------------------------------------------------------------------------
+// Name: get_modifier
+// Desc: default handler, only reached when there are too few arguments
+//------------------------------------------------------------------------------
+template <class Context, class CharT>
+CXX11_PRINTF_CONSTEXPR int get_modifier(Context &ctx, const CharT *format, Flags flags, long int width, long int precision, long int scale) CXX11_PRINTF_NOEXCEPT {
+	(void)format;
+	(void)flags;
+	(void)width;
+	(void)precision;
+	(void)scale;
+	return fail(ctx, format_errc::bad_format);
+}
+
+//------------------------------------------------------------------------------
+// Name: get_scale
+// Desc: default handler, only reached when there are too few arguments
+//------------------------------------------------------------------------------
+template <class Context, class CharT>
+CXX11_PRINTF_CONSTEXPR int get_scale(Context &ctx, const CharT *format, Flags flags, long int width, long int precision) CXX11_PRINTF_NOEXCEPT {
+	(void)format;
+	(void)flags;
+	(void)width;
+	(void)precision;
+	return fail(ctx, format_errc::bad_format);
+}
+
+//------------------------------------------------------------------------------
+// Name: get_precision
+// Desc: default handler, only reached when there are too few arguments
+//------------------------------------------------------------------------------
+template <class Context, class CharT>
+CXX11_PRINTF_CONSTEXPR int get_precision(Context &ctx, const CharT *format, Flags flags, long int width) CXX11_PRINTF_NOEXCEPT {
+	(void)format;
+	(void)flags;
+	(void)width;
+	return fail(ctx, format_errc::bad_format);
+}
+
+//------------------------------------------------------------------------------
+// Name: process_format
+// Desc: prints the next argument to the Context taking into account the flags,
+//       width, precision, and modifiers collected along the way. Then will
+//       recursively continue processing the string
+//------------------------------------------------------------------------------
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int process_format(Context &ctx, const CharT *format, Flags flags, long int width, long int precision, long int scale, Modifiers modifier, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+
+	if (*format == '\0') {
+		return fail(ctx, format_errc::bad_format);
+	}
 
-	default:
-		ctx.write('%');
-		// FALL THROUGH
-	case '\0':
-	case '%':
-		ctx.write(ch);
-		break;
+	format_errc err = format_errc::none;
+	const bool consumed = format_argument(ctx, *format, flags, width, precision, scale, modifier, arg, err);
+
+	if (err != format_errc::none) {
+		return fail_argument(ctx, err, format + 1, ts...);
 	}
 
-	return Printf(ctx, format + 1, ts...);
+	if (consumed) {
+		return printf_sequential(ctx, format + 1, ts...);
+	}
+
+	// unknown conversions are printed as-is and do not consume an argument
+	return printf_sequential(ctx, format + 1, arg, ts...);
 }
 
 //------------------------------------------------------------------------------
@@ -615,59 +2282,57 @@ int process_format(Context &ctx, const char *format, Flags flags, long int width
 // Desc: gets the modifier, if any, from the format string, then calls
 //       process_format
 //------------------------------------------------------------------------------
-template <class Context, class T, class... Ts>
-int get_modifier(Context &ctx, const char *format, Flags flags, long int width, long int precision, const T &arg, const Ts &... ts) {
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int get_modifier(Context &ctx, const CharT *format, Flags flags, long int width, long int precision, long int scale, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	Modifiers modifier = parse_modifier(format);
+	return process_format(ctx, format, flags, width, precision, scale, modifier, arg, ts...);
+}
 
+//------------------------------------------------------------------------------
+// Name: get_scale
+// Desc: gets the scale of a fixed point conversion, if any, either from the
+//       format string or as an arg as needed, then calls get_modifier
+//------------------------------------------------------------------------------
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int get_scale(Context &ctx, const CharT *format, Flags flags, long int width, long int precision, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
 
-	Modifiers modifier = Modifiers::MOD_NONE;
+	// default to an integer
+	long int scale = 0;
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+	if (*format == '/') {
 
-	switch (*format) {
-	case 'h':
-		modifier = Modifiers::MOD_SHORT;
-		++format;
-		if (*format == 'h') {
-			modifier = Modifiers::MOD_CHAR;
-			++format;
-		}
-		break;
-	case 'l':
-		modifier = Modifiers::MOD_LONG;
 		++format;
-		if (*format == 'l') {
-			modifier = Modifiers::MOD_LONG_LONG;
+		if (*format == '*') {
 			++format;
+			if (is_positional(format)) {
+				return fail(ctx, format_errc::mixed_positional);
+			}
+
+			// pull an int off the stack for processing
+			format_errc err = format_errc::none;
+			scale = formatted_integer<long int>(arg, err);
+			if (err != format_errc::none) {
+				return fail(ctx, err);
+			}
+
+			return get_modifier(ctx, format, flags, width, precision, scale, ts...);
+		} else {
+			scale = parse_long(format);
 		}
-		break;
-	case 'L':
-		modifier = Modifiers::MOD_LONG_DOUBLE;
-		++format;
-		break;
-	case 'j':
-		modifier = Modifiers::MOD_INTMAX_T;
-		++format;
-		break;
-	case 'z':
-		modifier = Modifiers::MOD_SIZE_T;
-		++format;
-		break;
-	case 't':
-		modifier = Modifiers::MOD_PTRDIFF_T;
-		++format;
-		break;
-	default:
-		break;
 	}
+#endif
 
-	return process_format(ctx, format, flags, width, precision, modifier, arg, ts...);
+	return get_modifier(ctx, format, flags, width, precision, scale, arg, ts...);
 }
 
 //------------------------------------------------------------------------------
 // Name: get_precision
 // Desc: gets the precision, if any, either from the format string or as an arg
-//       as needed, then calls get_modifier
+//       as needed, then calls get_scale
 //------------------------------------------------------------------------------
-template <class Context, class T, class... Ts>
-int get_precision(Context &ctx, const char *format, Flags flags, long int width, const T &arg, const Ts &... ts) {
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int get_precision(Context &ctx, const CharT *format, Flags flags, long int width, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
 
 	// default to non-existant
 	long int p = -1;
@@ -677,18 +2342,25 @@ int get_precision(Context &ctx, const char *format, Flags flags, long int width,
 		++format;
 		if (*format == '*') {
 			++format;
+			if (is_positional(format)) {
+				return fail(ctx, format_errc::mixed_positional);
+			}
+
 			// pull an int off the stack for processing
-			p = formatted_integer<long int>(arg);
-			return get_modifier(ctx, format, flags, width, p, ts...);
+			format_errc err = format_errc::none;
+			p = formatted_integer<long int>(arg, err);
+			if (err != format_errc::none) {
+				return fail(ctx, err);
+			}
+
+			return get_scale(ctx, format, flags, width, p, ts...);
 		} else {
-			char *endptr;
-			p = strtol(format, &endptr, 10);
-			format = endptr;
-			return get_modifier(ctx, format, flags, width, p, arg, ts...);
+			p = parse_long(format);
+			return get_scale(ctx, format, flags, width, p, arg, ts...);
 		}
 	}
 
-	return get_modifier(ctx, format, flags, width, p, arg, ts...);
+	return get_scale(ctx, format, flags, width, p, arg, ts...);
 }
 
 //------------------------------------------------------------------------------
@@ -696,21 +2368,32 @@ int get_precision(Context &ctx, const char *format, Flags flags, long int width,
 // Desc: gets the width if any, either from the format string or as an arg as
 //       needed, then calls get_precision
 //------------------------------------------------------------------------------
-template <class Context, class T, class... Ts>
-int get_width(Context &ctx, const char *format, Flags flags, const T &arg, const Ts &... ts) {
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int get_width(Context &ctx, const CharT *format, Flags flags, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
 
 	int width = 0;
 
 	if (*format == '*') {
 		++format;
+		if (is_positional(format)) {
+			return fail(ctx, format_errc::mixed_positional);
+		}
+
 		// pull an int off the stack for processing
-		width = formatted_integer<long int>(arg);
+		format_errc err = format_errc::none;
+		width = argument_width(formatted_integer<long int>(arg, err), flags);
+		if (err != format_errc::none) {
+			return fail(ctx, err);
+		}
 
 		return get_precision(ctx, format, flags, width, ts...);
 	} else {
-		char *endptr;
-		width = strtol(format, &endptr, 10);
-		format = endptr;
+		width = parse_long(format);
+
+		// "%n$" after a sequential conversion, POSIX says we may not mix them
+		if (*format == '$') {
+			return fail(ctx, format_errc::mixed_positional);
+		}
 
 		return get_precision(ctx, format, flags, width, arg, ts...);
 	}
@@ -720,111 +2403,407 @@ int get_width(Context &ctx, const char *format, Flags flags, const T &arg, const
 // Name: get_flags
 // Desc: gets the flags, if any, from the format string, then calls get_width
 //------------------------------------------------------------------------------
-template <class Context, class... Ts>
-int get_flags(Context &ctx, const char *format, const Ts &... ts) {
-
-	Flags f = {0, 0, 0, 0, 0, 0};
-	bool done = false;
+template <class Context, class CharT, class... Ts>
+CXX11_PRINTF_CONSTEXPR int get_flags(Context &ctx, const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
 
 	// skip past the % char
 	++format;
 
-	while (!done) {
+	Flags f = parse_flags(format);
+	return get_width(ctx, format, f, ts...);
+}
 
-		char ch = *format++;
+//------------------------------------------------------------------------------
+// Name: printf_sequential
+// Desc: 1+ argument version of printf_sequential. Consumes the arguments
+//       strictly left to right
+//------------------------------------------------------------------------------
+template <class Context, class CharT, class T, class... Ts>
+CXX11_PRINTF_CONSTEXPR int printf_sequential(Context &ctx, const CharT *format, const T &arg, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
 
-		switch (ch) {
-		case '-':
-			// justify, overrides padding
-			f.justify = 1;
-			f.padding = 0;
-			break;
-		case '+':
-			// sign, overrides space
-			f.sign = 1;
-			f.space = 0;
-			break;
-		case ' ':
-			if (!f.sign) {
-				f.space = 1;
-			}
-			break;
-		case '#':
-			f.prefix = 1;
-			break;
-		case '0':
-			if (!f.justify) {
-				f.padding = 1;
-			}
-			break;
-		default:
-			done = true;
-			--format;
-		}
+	format = write_literal(ctx, format);
+	if (*format != '\0') {
+		// %[flag][width][.precision][/scale][length]char
+
+		// this recurses into get_width -> get_precision -> get_scale -> get_modifier -> process_format
+		return get_flags(ctx, format, arg, ts...);
 	}
 
-	return get_width(ctx, format, f, ts...);
+	// NOTE(eteran): like printf, any excess arguments are simply ignored
+	ctx.done();
+	return ctx.written;
+}
+
+// NOTE(eteran): in positional mode, the arguments are placed into a table once
+//               per call, each entry knowing how to format and convert its own
+//               type, so that referencing argument N is O(1) rather than a
+//               recursion N levels deep
+template <class Context>
+struct argument {
+	const void *ptr;
+	bool (*format)(Context &ctx, typename context_char<Context>::type ch, Flags flags, long int width, long int precision, long int scale, Modifiers modifier, const void *arg, format_errc &err);
+	long int (*integer)(const void *arg, format_errc &err);
+};
+
+template <class Context, class T>
+bool format_erased(Context &ctx, typename context_char<Context>::type ch, Flags flags, long int width, long int precision, long int scale, Modifiers modifier, const void *arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	return format_argument(ctx, ch, flags, width, precision, scale, modifier, *static_cast<const T *>(arg), err);
 }
+
+template <class T>
+long int integer_erased(const void *arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+	return formatted_integer<long int>(*static_cast<const T *>(arg), err);
+}
+
+template <class Context, class T>
+argument<Context> make_argument(const T &arg) {
+	return argument<Context>{&arg, format_erased<Context, T>, integer_erased<T>};
 }
 
 //------------------------------------------------------------------------------
-// Name: Printf
-// Desc: 0 argument version of Printf. Asserts on any format character found
+// Name: get_argument
+// Desc: parses a "n$" argument index from the format string and returns the
+//       corresponding entry of the argument table, or nullptr on error
 //------------------------------------------------------------------------------
-template <class Context>
-int Printf(Context &ctx, const char *format) {
+template <class Context, size_t N, class CharT>
+const argument<Context> *get_argument(const std::array<argument<Context>, N> &args, const CharT *&format, format_errc &err) noexcept {
 
-	assert(format);
+	if (!is_positional(format)) {
+		err = format_errc::mixed_positional;
+		return nullptr;
+	}
 
-	for (; *format; ++format) {
+	// NOTE(eteran): skips the '$' too
+	const unsigned long int index = parse_long(format);
+	++format;
+
+	if (index > N) {
+		err = format_errc::positional_out_of_range;
+		return nullptr;
+	}
+
+	return &args[index - 1];
+}
+
+//------------------------------------------------------------------------------
+// Name: printf_positional
+// Desc: handles formats using POSIX "%n$" and "*m$" argument references
+//------------------------------------------------------------------------------
+template <class Context, class CharT, class... Ts>
+int printf_positional(Context &ctx, const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+
+	const std::array<argument<Context>, sizeof...(Ts)> args = {{make_argument<Context>(ts)...}};
+
+	format_errc err    = format_errc::none;
+	int         result = 0;
+
+	while (*format != '\0') {
 		if (*format != '%' || *++format == '%') {
-			ctx.write(*format);
+			ctx.write(*format++);
 			continue;
 		}
 
-		throw format_error("Bad Format");
+		// %n$[flag][width][.precision][/scale][length]char
+		const argument<Context> *arg = get_argument(args, format, err);
+		if (!arg) {
+			return fail(ctx, err);
+		}
+
+		Flags flags = parse_flags(format);
+
+		long int width = 0;
+		if (*format == '*') {
+			++format;
+			const argument<Context> *w = get_argument(args, format, err);
+			if (!w) {
+				return fail(ctx, err);
+			}
+
+			width = argument_width(w->integer(w->ptr, err), flags);
+			if (err != format_errc::none) {
+				return fail(ctx, err);
+			}
+		} else {
+			width = parse_long(format);
+		}
+
+		// default to non-existant
+		long int precision = -1;
+		if (*format == '.') {
+			++format;
+			if (*format == '*') {
+				++format;
+				const argument<Context> *p = get_argument(args, format, err);
+				if (!p) {
+					return fail(ctx, err);
+				}
+
+				precision = p->integer(p->ptr, err);
+				if (err != format_errc::none) {
+					return fail(ctx, err);
+				}
+			} else {
+				precision = parse_long(format);
+			}
+		}
+
+		// default to an integer
+		long int scale = 0;
+#ifdef CXX11_PRINTF_EXTENSIONS
+		if (*format == '/') {
+			++format;
+			if (*format == '*') {
+				++format;
+				const argument<Context> *s = get_argument(args, format, err);
+				if (!s) {
+					return fail(ctx, err);
+				}
+
+				scale = s->integer(s->ptr, err);
+				if (err != format_errc::none) {
+					return fail(ctx, err);
+				}
+			} else {
+				scale = parse_long(format);
+			}
+		}
+#endif
+
+		Modifiers modifier = parse_modifier(format);
+
+		if (*format == '\0') {
+			return fail(ctx, format_errc::bad_format);
+		}
+
+		arg->format(ctx, *format, flags, width, precision, scale, modifier, arg->ptr, err);
+		if (err != format_errc::none) {
+#if defined(CXX11_PRINTF_NO_EXCEPTIONS) && !defined(CXX11_PRINTF_STOP_ON_ERROR)
+			// NOTE(eteran): skip the conversion and keep going
+			set_error(ctx, err, 0);
+			err    = format_errc::none;
+			result = -1;
+#else
+			return fail(ctx, err);
+#endif
+		}
+
+		++format;
 	}
 
-	// this will usually null terminate the string
 	ctx.done();
+	return result < 0 ? result : static_cast<int>(ctx.written);
+}
 
-	// return the amount of bytes that should have been written if there was sufficient space
-	return ctx.written;
+// NOTE(eteran): the rest of the detail namespace computes an upper bound on the
+//               output of a format at compile time. Everything here must be a
+//               single return statement to be a C++11 constexpr function
+constexpr size_t unbounded = static_cast<size_t>(-1);
+
+constexpr size_t bound_add(size_t a, size_t b) {
+	return (a == unbounded || b == unbounded) ? unbounded : a + b;
+}
+
+constexpr size_t bound_max(size_t a, size_t b) {
+	return (a == unbounded || b == unbounded) ? unbounded : (a > b) ? a : b;
+}
+
+constexpr bool is_digit(char ch) {
+	return ch >= '0' && ch <= '9';
+}
+
+// NOTE(eteran): true if the next n chars are plain literal chars. Skipping
+//               literals in blocks keeps long formats within the limits on
+//               constexpr recursion depth
+constexpr bool is_plain(const char *format, size_t n) {
+	return n == 0 || (*format != '%' && *format != '\0' && is_plain(format + 1, n - 1));
+}
+
+constexpr const char *skip_digits(const char *format) {
+	return is_digit(*format) ? skip_digits(format + 1) : format;
+}
+
+constexpr size_t parse_digits(const char *format, size_t n) {
+	return is_digit(*format) ? parse_digits(format + 1, n * 10 + (*format - '0')) : n;
+}
+
+constexpr const char *skip_modifier(const char *format) {
+	return ((format[0] == 'h' && format[1] == 'h') || (format[0] == 'l' && format[1] == 'l')) ? format + 2 :
+	       (*format == 'h' || *format == 'l' || *format == 'L' || *format == 'j' || *format == 'z' || *format == 't') ? format + 1 :
+	       format;
+}
+
+// the size of the integer type which a modifier converts the argument to
+constexpr size_t modifier_size(const char *format) {
+	return (format[0] == 'h' && format[1] == 'h') ? sizeof(char) :
+	       (format[0] == 'l' && format[1] == 'l') ? sizeof(long long int) :
+	       (*format == 'h') ? sizeof(short int) :
+	       (*format == 'l') ? sizeof(long int) :
+	       (*format == 'j') ? sizeof(intmax_t) :
+	       (*format == 'z') ? sizeof(size_t) :
+	       (*format == 't') ? sizeof(ptrdiff_t) :
+	       sizeof(int);
+}
+
+// the l modifier without a second l, which makes %c take a code point
+constexpr bool is_wide(const char *format) {
+	return format[0] == 'l' && format[1] != 'l';
+}
+
+// the most decimal digits an integer of the given size can have
+constexpr size_t decimal_digits(size_t size) {
+	return (size == 1) ? 3 : (size == 2) ? 5 : (size == 4) ? 10 : 20;
+}
+
+//------------------------------------------------------------------------------
+// Name: conversion_bound
+// Desc: the most chars a single conversion can produce, for an integer of the
+//       given size, or wide for the l modifier. grouping is the ' flag,
+//       precision is unbounded if absent and scale is that of %k, 0 if absent
+//------------------------------------------------------------------------------
+constexpr size_t conversion_bound(char ch, size_t size, bool wide, bool grouping, size_t width, size_t precision, size_t scale) {
+	// NOTE(eteran): a context may group every digit, and any integer may be signed
+	return bound_max(width,
+		(ch == 'd' || ch == 'i' || ch == 'u') ? 1 + decimal_digits(size) + (grouping ? decimal_digits(size) - 1 : 0) :
+		(ch == 'x' || ch == 'X') ? 2 + size * 2 :
+		(ch == 'o') ? 1 + (size * 8 + 2) / 3 :
+		(ch == 'p') ? 2 + sizeof(uintptr_t) * 2 :
+		(ch == 'c') ? (wide ? 4 : 1) :
+		(ch == 'n') ? 0 :
+		(ch == 'e' || ch == 'E' || ch == 'f' || ch == 'F' || ch == 'a' || ch == 'A' || ch == 'g' || ch == 'G') ? 0 :
+		(ch == 's') ? precision :
+#ifdef CXX11_PRINTF_EXTENSIONS
+		(ch == 'b') ? 2 + size * 8 :
+		(ch == 'k') ? bound_add(1 + 20 + 19 + 1, (precision != unbounded) ? precision : scale) :
+		(ch == 'r') ? 25 :
+		(ch == 'T') ? 48 :
+		(ch == 'J') ? bound_max(precision, precision * 6) :
+		(ch == 'y' || ch == 'Y') ? bound_max(precision, precision * 3) :
+#endif
+		unbounded);
+}
+
+template <class... Ts>
+struct type_list {};
+
+// NOTE(eteran): only used in unevaluated contexts, to name the types of a list of arguments
+template <class... Ts>
+type_list<Ts...> argument_types(const Ts &...);
+
+template <class... Ts>
+struct format_bound_impl;
+
+// NOTE(eteran): with no arguments left, any conversion fails at runtime, so
+//               there is no bound to speak of
+template <>
+struct format_bound_impl<> {
+	static constexpr size_t literal(const char *format) {
+		return is_plain(format, 16) ? bound_add(16, literal(format + 16)) :
+		       (*format == '\0') ? 0 :
+		       (*format != '%') ? bound_add(1, literal(format + 1)) :
+		       (format[1] == '%') ? bound_add(1, literal(format + 2)) :
+		       unbounded;
+	}
+};
+
+template <class T, class... Ts>
+struct format_bound_impl<T, Ts...> {
+	static constexpr size_t literal(const char *format) {
+		return is_plain(format, 16) ? bound_add(16, literal(format + 16)) :
+		       (*format == '\0') ? 0 :
+		       (*format != '%') ? bound_add(1, literal(format + 1)) :
+		       (format[1] == '%') ? bound_add(1, literal(format + 2)) :
+		       flags(format + 1, false);
+	}
+
+	static constexpr size_t flags(const char *format, bool grouping) {
+		return (*format == '-' || *format == '+' || *format == ' ' || *format == '#' || *format == '0') ? flags(format + 1, grouping) :
+		       (*format == '\'') ? flags(format + 1, true) :
+		       width(format, grouping);
+	}
+
+	// NOTE(eteran): an argument supplied width, precision or scale could be anything,
+	//               as could positional arguments
+	static constexpr size_t width(const char *format, bool grouping) {
+		return (*format == '*') ? unbounded :
+		       (*skip_digits(format) == '$') ? unbounded :
+		       precision(skip_digits(format), grouping, parse_digits(format, 0));
+	}
+
+	static constexpr size_t precision(const char *format, bool grouping, size_t w) {
+		return (*format != '.') ? scale(format, grouping, w, unbounded) :
+		       (format[1] == '*') ? unbounded :
+		       scale(skip_digits(format + 1), grouping, w, parse_digits(format + 1, 0));
+	}
+
+	// NOTE(eteran): a negative scale multiplies, so only plain digits are bounded
+	static constexpr size_t scale(const char *format, bool grouping, size_t w, size_t p) {
+#ifdef CXX11_PRINTF_EXTENSIONS
+		return (*format != '/') ? conversion(format, grouping, w, p, 0) :
+		       !is_digit(format[1]) ? unbounded :
+		       conversion(skip_digits(format + 1), grouping, w, p, parse_digits(format + 1, 0));
+#else
+		return conversion(format, grouping, w, p, 0);
+#endif
+	}
+
+	static constexpr size_t conversion(const char *format, bool grouping, size_t w, size_t p, size_t s) {
+		return next(skip_modifier(format), conversion_bound(*skip_modifier(format), modifier_size(format), is_wide(format), grouping, w, p, s));
+	}
+
+	// unknown conversions are printed as-is and do not consume an argument
+	static constexpr size_t next(const char *format, size_t n) {
+		return (*format == '\0') ? unbounded :
+		       (n == unbounded && !is_known(*format)) ? bound_add(2, literal(format + 1)) :
+		       bound_add(n, format_bound_impl<Ts...>::literal(format + 1));
+	}
+
+	static constexpr bool is_known(char ch) {
+		return ch == 'd' || ch == 'i' || ch == 'u' || ch == 'x' || ch == 'X' || ch == 'o' || ch == 'p' || ch == 'c' || ch == 'n' || ch == 's' ||
+		       ch == 'e' || ch == 'E' || ch == 'f' || ch == 'F' || ch == 'a' || ch == 'A' || ch == 'g' || ch == 'G'
+#ifdef CXX11_PRINTF_EXTENSIONS
+		       || ch == 'b' || ch == 'k' || ch == 'r' || ch == 'T' || ch == 'J' || ch == 'y' || ch == 'Y' || ch == '?'
+#endif
+		       ;
+	}
+};
 }
 
 //------------------------------------------------------------------------------
 // Name: Printf
-// Desc: 1+ argument version of Printf.
+// Desc: formats the arguments into the Context according to format. Supports
+//       both sequential and POSIX positional ("%1$d") argument references
 //------------------------------------------------------------------------------
-template <class Context, class... Ts>
-int Printf(Context &ctx, const char *format, const Ts &... ts) {
+template <class Context, class CharT, class... Ts>
+CXX11_PRINTF_CONSTEXPR int Printf(Context &ctx, const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+
+	static_assert(std::is_same<CharT, typename detail::context_char<Context>::type>::value, "the format must be of the same character type as the context");
 
 	assert(format);
 
-	while (*format != '\0') {
-		if (*format == '%') {
-			// %[flag][width][.precision][length]char
+#ifdef CXX11_PRINTF_INSTRUMENT
+	const instrument::call_timer timer;
+#endif
 
-			// this recurses into get_width -> get_precision -> get_length -> process_format
-			return detail::get_flags(ctx, format, ts...);
-		} else {
-			ctx.write(*format);
-		}
+	detail::start_call(ctx, 0);
 
-		++format;
+	// NOTE(eteran): per POSIX, the first conversion decides the mode for the
+	//               whole format, so the text before it is written here and
+	//               the format is only ever scanned once
+	format = detail::write_literal(ctx, format);
+	if (*format != '\0' && detail::is_positional(format + 1)) {
+		return detail::printf_positional(ctx, format, ts...);
 	}
 
-	// clean up any trailing stuff
-	return Printf(ctx, format + 1, ts...);
+	return detail::printf_sequential(ctx, format, ts...);
 }
 
 //------------------------------------------------------------------------------
 // Name: snprintf
 // Desc: implementation of what snprintf compatible interface
 //------------------------------------------------------------------------------
-template <class... Ts>
-int sprintf(std::ostream &os, const char *format, const Ts &... ts) {
-	ostream_writer ctx(os);
+template <class CharT, class... Ts>
+int sprintf(std::basic_ostream<CharT> &os, const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	basic_ostream_writer<CharT> ctx(os);
 	return Printf(ctx, format, ts...);
 }
 
@@ -832,19 +2811,106 @@ int sprintf(std::ostream &os, const char *format, const Ts &... ts) {
 // Name: sprintf
 // Desc: implementation of what s[n]printf compatible interface
 //------------------------------------------------------------------------------
+template <class CharT, class... Ts>
+int sprintf(CharT *str, size_t size, const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	basic_buffer_writer<CharT> ctx(str, size);
+	return Printf(ctx, format, ts...);
+}
+
+//------------------------------------------------------------------------------
+// Name: format_bound
+// Desc: returns an upper bound on the number of chars (not including the NUL
+//       terminator) which format can produce with arguments of types Ts, or
+//       SIZE_MAX if it cannot be bounded, for example when it contains a %s
+//       without a precision or a '*' width
+//------------------------------------------------------------------------------
+template <class... Ts>
+constexpr size_t format_bound(const char *format) {
+	return detail::format_bound_impl<Ts...>::literal(format);
+}
+
 template <class... Ts>
-int sprintf(char *str, size_t size, const char *format, const Ts &... ts) {
-	buffer_writer ctx(str, size);
+constexpr size_t format_bound(detail::type_list<Ts...>, const char *format) {
+	return detail::format_bound_impl<Ts...>::literal(format);
+}
+
+//------------------------------------------------------------------------------
+// Name: sprintf_bounded
+// Desc: formats into a std::array, given Bound, the format_bound of the format.
+//       When the output is known to fit, the bounds checks are skipped entirely
+// Note: the CXX11_SPRINTF macro computes the bound from a literal format
+//------------------------------------------------------------------------------
+template <size_t Bound, size_t N, class... Ts>
+int sprintf_bounded(std::array<char, N> &str, const char *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	static_assert(N != 0, "cannot format into an empty array");
+
+	if (Bound < N) {
+		unchecked_writer ctx(str.data());
+		return Printf(ctx, format, ts...);
+	}
+
+	buffer_writer ctx(str.data(), N);
+	return Printf(ctx, format, ts...);
+}
+
+//------------------------------------------------------------------------------
+// Name: sprintf
+// Desc: formats into a std::array, truncating as needed
+//------------------------------------------------------------------------------
+template <size_t N, class... Ts>
+int sprintf(std::array<char, N> &str, const char *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	return sprintf_bounded<detail::unbounded>(str, format, ts...);
+}
+
+template <class CharT, size_t N, class... Ts>
+int sprintf(std::array<CharT, N> &str, const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	static_assert(N != 0, "cannot format into an empty array");
+	basic_buffer_writer<CharT> ctx(str.data(), N);
 	return Printf(ctx, format, ts...);
 }
 
+#ifdef __cpp_lib_string_view
+//------------------------------------------------------------------------------
+// Name: format_arena
+// Desc: formats into an arena, returning a view of the NUL terminated result
+//       which stays valid until the arena is reset
+//------------------------------------------------------------------------------
+template <class... Ts>
+std::string_view format_arena(arena &a, const char *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	arena_writer ctx(a);
+	Printf(ctx, format, ts...);
+	return ctx.view();
+}
+#endif
+
+#ifdef CXX11_PRINTF_HAS_CONSTEXPR
+//------------------------------------------------------------------------------
+// Name: format_array
+// Desc: formats into a NUL terminated std::array of N CharT. This may be
+//       evaluated at compile time, except for %n, %p, %T, %y, %? and positional
+//       arguments
+//------------------------------------------------------------------------------
+template <size_t N, class CharT, class... Ts>
+constexpr std::array<CharT, N> format_array(const CharT *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+	basic_array_writer<CharT, N> ctx;
+	Printf(ctx, format, ts...);
+	return ctx.buffer;
+}
+#endif
+
 //------------------------------------------------------------------------------
 // Name: printf
 // Desc: implementation of what printf compatible interface
+// Note: when CXX11_PRINTF_ATOMIC is defined, the output of each call is written
+//       to stdout in one piece, so concurrent calls never interleave
 //------------------------------------------------------------------------------
 template <class... Ts>
-int printf(const char *format, const Ts &... ts) {
+int printf(const char *format, const Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+#ifdef CXX11_PRINTF_ATOMIC
+	atomic_writer ctx(stdout);
+#else
 	stdout_writer ctx;
+#endif
 	return Printf(ctx, format, ts...);
 }
 }
@@ -0,0 +1,112 @@
+
+#ifndef READERS_20160922_H_
+#define READERS_20160922_H_
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+
+namespace cxx11 {
+
+// NOTE(eteran): a reader context is the input side of a writer context. peek()
+//               returns the next char of the input as an unsigned char, or EOF
+//               at the end of it, and advance() moves past the char peek just
+//               returned. "consumed" counts the chars moved past, for %n
+
+// NOTE(eteran): readers of input which is all in memory may optionally provide
+//               remaining(n) and consume(n). remaining returns a pointer to all
+//               of the unread input, setting n to its length, so that conversions
+//               can scan it directly. consume(n) then moves past the first n chars
+
+// This context reads from a buffer
+struct buffer_reader {
+
+	buffer_reader(const char *buffer, size_t size) : ptr_(buffer), end_(buffer + size) {
+	}
+
+	buffer_reader(const char *s) : buffer_reader(s, strlen(s)) {
+	}
+
+	int peek() const noexcept {
+		return (ptr_ != end_) ? static_cast<unsigned char>(*ptr_) : EOF;
+	}
+
+	void advance() noexcept {
+		++ptr_;
+		++consumed;
+	}
+
+	const char *remaining(size_t &n) const noexcept {
+		n = end_ - ptr_;
+		return ptr_;
+	}
+
+	void consume(size_t n) noexcept {
+		ptr_     += n;
+		consumed += n;
+	}
+
+	const char *ptr_;
+	const char *end_;
+	size_t consumed = 0;
+};
+
+// this context reads from an STDIO stream. Like scanf, it looks at most one char
+// ahead, which is pushed back onto the stream when the reader is destroyed
+struct stdio_reader {
+
+	stdio_reader(FILE *stream) : stream_(stream) {
+	}
+
+	~stdio_reader() {
+		if(peeked_ && next_ != EOF) {
+			ungetc(next_, stream_);
+		}
+	}
+
+	stdio_reader(const stdio_reader &) = delete;
+	stdio_reader &operator=(const stdio_reader &) = delete;
+
+	int peek() noexcept {
+		if(!peeked_) {
+			next_   = getc(stream_);
+			peeked_ = true;
+		}
+		return next_;
+	}
+
+	void advance() noexcept {
+		peeked_ = false;
+		++consumed;
+	}
+
+	FILE *stream_;
+	int   next_   = EOF;
+	bool  peeked_ = false;
+	size_t consumed = 0;
+};
+
+// This context reads from a std::istream, through its stream buffer
+struct istream_reader {
+
+	istream_reader(std::istream &is) : buf_(is.rdbuf()) {
+	}
+
+	int peek() {
+		return buf_->sgetc();
+	}
+
+	void advance() {
+		buf_->sbumpc();
+		++consumed;
+	}
+
+	std::streambuf *buf_;
+	size_t consumed = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,1237 @@
+
+#ifndef SCANF_20160922_H_
+#define SCANF_20160922_H_
+
+// NOTE(eteran): the input side of Printf. The format grammar is scanf's, parsed
+//               with the same helpers as Printf's, and since the type of every
+//               argument is known, each conversion is checked against it. The
+//               modifiers are accepted, but it is the type pointed to which
+//               decides the range or precision of the conversion, so "%f" reads
+//               a double into a double *
+
+#include "Printf.h"
+#include "Readers.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+
+namespace cxx11 {
+namespace detail {
+
+// the value of each char as a digit, or 0xff if it isn't one, so that a digit of
+// any base is checked with a single comparison
+static const uint8_t digit_values[256] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+};
+
+inline unsigned int digit_value(int ch) noexcept {
+	return (static_cast<unsigned int>(ch) < 256) ? digit_values[ch] : 0xff;
+}
+
+inline bool is_space(int ch) noexcept {
+	return ch == ' ' || static_cast<unsigned int>(ch - '\t') < 5;
+}
+
+// the argument of a suppressed ("%*d") conversion
+struct discard {};
+
+enum class scan_status {
+	matched,   // the conversion matched the input
+	mismatch,  // the input didn't match, a "matching failure"
+	input_end  // the input ended first, an "input failure"
+};
+
+// a conversion, as parsed from the format
+struct ScanSpec {
+	size_t   width;      // SIZE_MAX when there is none
+	char     conversion;
+	bool     suppress;
+	bool     grouping;
+	uint64_t set[4];     // the chars matched by %[
+};
+
+// NOTE(eteran): readers may optionally expose all of their unread input, see
+//               Readers.h
+template <class Reader>
+struct has_remaining {
+private:
+	template <class R>
+	static auto test(int) -> decltype(std::declval<R &>().consume(size_t()), static_cast<const char *>(std::declval<R &>().remaining(std::declval<size_t &>())), std::true_type());
+
+	template <class R>
+	static std::false_type test(long);
+
+public:
+	static constexpr bool value = decltype(test<Reader>(0))::value;
+};
+
+// NOTE(eteran): the conversions read their field through a cursor, which stops
+//               at the field width. When the reader has all of its input in
+//               memory, the cursor is a plain range of it
+struct span_cursor {
+	int peek() const noexcept {
+		return (p != end) ? static_cast<unsigned char>(*p) : EOF;
+	}
+
+	void advance() noexcept {
+		++p;
+	}
+
+	const char *p;
+	const char *end;
+};
+
+template <class Reader>
+struct reader_cursor {
+	int peek() {
+		return remaining ? reader.peek() : EOF;
+	}
+
+	void advance() {
+		reader.advance();
+		--remaining;
+	}
+
+	Reader &reader;
+	size_t  remaining;
+};
+
+// a reader_cursor which also keeps a copy of the chars it moves past
+template <class Reader>
+struct recording_cursor {
+	int peek() {
+		return remaining ? reader.peek() : EOF;
+	}
+
+	void advance() {
+		buffer[length++] = static_cast<char>(reader.peek());
+		reader.advance();
+		--remaining;
+	}
+
+	Reader &reader;
+	size_t  remaining;
+	char   *buffer;
+	size_t  length;
+};
+
+template <class Reader>
+void skip_space(Reader &r) {
+	while (is_space(r.peek())) {
+		r.advance();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_scanset
+// Desc: parses the chars of a %[ conversion into set. format points just past
+//       the '[', and is moved past the closing ']'. Returns false if there is none
+//------------------------------------------------------------------------------
+inline bool parse_scanset(const char *&format, uint64_t (&set)[4]) noexcept {
+
+	set[0] = set[1] = set[2] = set[3] = 0;
+
+	bool invert = false;
+	if (*format == '^') {
+		invert = true;
+		++format;
+	}
+
+	// NOTE(eteran): a ']' straight after the '[' or '^' is one of the chars
+	const char *first = format;
+	while (*format != ']' || format == first) {
+		if (*format == '\0') {
+			return false;
+		}
+
+		const unsigned char lo = *format++;
+		unsigned char hi       = lo;
+
+		// a '-' which isn't first or last is a range, as in glibc
+		if (*format == '-' && format[1] != ']' && format[1] != '\0' && static_cast<unsigned char>(format[1]) >= lo) {
+			hi = format[1];
+			format += 2;
+		}
+
+		for (unsigned int ch = lo; ch <= hi; ++ch) {
+			set[ch >> 6] |= uint64_t(1) << (ch & 63);
+		}
+	}
+
+	++format;
+
+	if (invert) {
+		for (uint64_t &bits : set) {
+			bits = ~bits;
+		}
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_eight_digits
+// Desc: converts 8 decimal digits at once, returns false if they aren't all
+//       digits. See "Fast numeric string to int", Lemire
+//------------------------------------------------------------------------------
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+inline bool parse_eight_digits(const char *p, uint64_t &value) noexcept {
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+
+	if (((v & 0xf0f0f0f0f0f0f0f0) | (((v + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) != 0x3333333333333333) {
+		return false;
+	}
+
+	v -= 0x3030303030303030;
+	v = (v * 10) + (v >> 8);
+	v = (((v & 0x000000ff000000ff) * (100 + (1000000ull << 32))) + (((v >> 16) & 0x000000ff000000ff) * (1 + (10000ull << 32)))) >> 32;
+	value = v;
+	return true;
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Name: parse_decimal_run
+// Desc: consumes up to 16 leading decimal digits 8 at a time, which can't
+//       overflow, leaving any others to the usual loop
+//------------------------------------------------------------------------------
+inline void parse_decimal_run(span_cursor &c, uintmax_t &n, bool &digits) noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	uint64_t chunk;
+	for (int i = 0; i < 2 && c.end - c.p >= 8 && parse_eight_digits(c.p, chunk); ++i) {
+		n = n * 100000000 + chunk;
+		c.p += 8;
+		digits = true;
+	}
+#else
+	(void)c;
+	(void)n;
+	(void)digits;
+#endif
+}
+
+template <class Cursor>
+void parse_decimal_run(Cursor &, uintmax_t &, bool &) noexcept {
+}
+
+//------------------------------------------------------------------------------
+// Name: skip_separator
+// Desc: moves past a thousands separator, returns true if a digit follows it
+// Note: a cursor over memory looks ahead and stops in front of a separator
+//       which isn't followed by a digit. Other readers can only see one char
+//       ahead, so by then the separator has been consumed
+//------------------------------------------------------------------------------
+inline bool skip_separator(span_cursor &c, unsigned int base) noexcept {
+	if (c.end - c.p < 2 || digit_value(static_cast<unsigned char>(c.p[1])) >= base) {
+		return false;
+	}
+
+	++c.p;
+	return true;
+}
+
+template <class Cursor>
+bool skip_separator(Cursor &c, unsigned int base) {
+	c.advance();
+	return digit_value(c.peek()) < base;
+}
+
+struct integer_value {
+	uintmax_t magnitude;
+	bool      negative;
+	bool      overflow;
+};
+
+//------------------------------------------------------------------------------
+// Name: parse_integer
+// Desc: equivalent to strtoumax(p, &endptr, base), with the sign kept apart.
+//       separator is skipped when it is between digits, or is EOF for none.
+//       Returns false if there were no digits
+//------------------------------------------------------------------------------
+template <class Cursor>
+bool parse_integer(Cursor &c, unsigned int base, int separator, integer_value &v) {
+
+	v.negative = false;
+	v.overflow = false;
+
+	int ch = c.peek();
+	if (ch == '+' || ch == '-') {
+		v.negative = (ch == '-');
+		c.advance();
+		ch = c.peek();
+	}
+
+	// NOTE(eteran): a lone "0x" reads as 0, much like glibc
+	bool digits = false;
+	if (ch == '0' && (base == 0 || base == 16 || base == 2)) {
+		c.advance();
+		ch     = c.peek();
+		digits = true;
+
+		if ((ch | 0x20) == 'x' && base != 2) {
+			c.advance();
+			ch   = c.peek();
+			base = 16;
+		} else if ((ch | 0x20) == 'b' && base == 2) {
+			c.advance();
+			ch = c.peek();
+		} else if (base == 0) {
+			base = 8;
+		}
+	}
+
+	if (base == 0) {
+		base = 10;
+	}
+
+	uintmax_t n = 0;
+	if (base == 10 && separator == EOF) {
+		parse_decimal_run(c, n, digits);
+		ch = c.peek();
+	}
+
+#if !defined(__GNUC__) && !defined(__clang__)
+	const uintmax_t limit       = std::numeric_limits<uintmax_t>::max() / base;
+	const unsigned int last_digit = std::numeric_limits<uintmax_t>::max() % base;
+#endif
+
+	while (true) {
+		const unsigned int d = digit_value(ch);
+		if (d >= base) {
+			if (ch == separator && ch != EOF && digits && skip_separator(c, base)) {
+				ch = c.peek();
+				continue;
+			}
+			break;
+		}
+
+#if defined(__GNUC__) || defined(__clang__)
+		v.overflow |= __builtin_mul_overflow(n, base, &n);
+		v.overflow |= __builtin_add_overflow(n, d, &n);
+#else
+		if (n > limit || (n == limit && d > last_digit)) {
+			v.overflow = true;
+		} else {
+			n = n * base + d;
+		}
+#endif
+		digits = true;
+		c.advance();
+		ch = c.peek();
+	}
+
+	v.magnitude = n;
+	return digits;
+}
+
+//------------------------------------------------------------------------------
+// Name: match_word
+// Desc: matches word, ignoring case
+//------------------------------------------------------------------------------
+template <class Cursor>
+bool match_word(Cursor &c, const char *word) {
+	for (; *word; ++word) {
+		if ((c.peek() | 0x20) != *word) {
+			return false;
+		}
+		c.advance();
+	}
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: match_float
+// Desc: moves past the text of a floating point number, as accepted by strtod.
+//       Returns false if it doesn't start with one. Like glibc, a field which
+//       ends early, as in "1e+", is converted as far as it is valid
+//------------------------------------------------------------------------------
+template <class Cursor>
+bool match_float(Cursor &c) {
+
+	int ch = c.peek();
+	if (ch == '+' || ch == '-') {
+		c.advance();
+		ch = c.peek();
+	}
+
+	if ((ch | 0x20) == 'i') {
+		if (!match_word(c, "inf")) {
+			return false;
+		}
+		return (c.peek() | 0x20) != 'i' || match_word(c, "inity");
+	}
+
+	if ((ch | 0x20) == 'n') {
+		if (!match_word(c, "nan")) {
+			return false;
+		}
+
+		if (c.peek() == '(') {
+			c.advance();
+			while ((ch = c.peek()) != ')') {
+				if (digit_value(ch) >= 10 && ((ch | 0x20) < 'a' || (ch | 0x20) > 'z') && ch != '_') {
+					return ch == EOF;
+				}
+				c.advance();
+			}
+			c.advance();
+		}
+		return true;
+	}
+
+	unsigned int base = 10;
+	bool digits       = false;
+
+	if (ch == '0') {
+		c.advance();
+		ch     = c.peek();
+		digits = true;
+		if ((ch | 0x20) == 'x') {
+			c.advance();
+			ch     = c.peek();
+			base   = 16;
+			digits = false;
+		}
+	}
+
+	for (; digit_value(ch) < base; ch = c.peek()) {
+		digits = true;
+		c.advance();
+	}
+
+	if (ch == '.') {
+		c.advance();
+		for (ch = c.peek(); digit_value(ch) < base; ch = c.peek()) {
+			digits = true;
+			c.advance();
+		}
+	}
+
+	if (!digits) {
+		return false;
+	}
+
+	if ((ch | 0x20) == ((base == 16) ? 'p' : 'e')) {
+		c.advance();
+		ch = c.peek();
+		if (ch == '+' || ch == '-') {
+			c.advance();
+			ch = c.peek();
+		}
+
+		if (digit_value(ch) >= 10) {
+			return ch == EOF;
+		}
+
+		do {
+			c.advance();
+		} while (digit_value(c.peek()) < 10);
+	}
+
+	return true;
+}
+
+inline void string_to_float(const char *s, float &value) noexcept {
+	value = strtof(s, nullptr);
+}
+
+inline void string_to_float(const char *s, double &value) noexcept {
+	value = strtod(s, nullptr);
+}
+
+inline void string_to_float(const char *s, long double &value) noexcept {
+	value = strtold(s, nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Name: parse_float
+// Desc: converts the text found by match_float. Uses std::from_chars when it is
+//       available, which is both faster and independent of the locale. Falls
+//       back to strtod, which also gives the usual results for out of range input
+//------------------------------------------------------------------------------
+template <class F>
+void parse_float(const char *first, const char *last, F &value) {
+
+#ifdef __cpp_lib_to_chars
+	const char *p = first;
+
+	bool negative = false;
+	if (*p == '+' || *p == '-') {
+		negative = (*p == '-');
+		++p;
+	}
+
+	std::chars_format fmt = std::chars_format::general;
+	if (last - p > 2 && p[0] == '0' && (p[1] | 0x20) == 'x') {
+		fmt = std::chars_format::hex;
+		p += 2;
+	}
+
+	if (std::from_chars(p, last, value, fmt).ec == std::errc()) {
+		if (negative) {
+			value = -value;
+		}
+		return;
+	}
+#endif
+
+	char buf[128];
+	const size_t n = last - first;
+	if (n < sizeof(buf)) {
+		memcpy(buf, first, n);
+		buf[n] = '\0';
+		string_to_float(buf, value);
+	} else {
+		string_to_float(std::string(first, last).c_str(), value);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: read_integer
+// Desc: reads an integer field from the Reader
+//------------------------------------------------------------------------------
+template <class Reader>
+bool read_integer(Reader &r, size_t width, unsigned int base, int separator, integer_value &v, std::true_type) {
+	size_t n;
+	const char *p = r.remaining(n);
+	span_cursor c = {p, p + std::min(n, width)};
+	const bool digits = parse_integer(c, base, separator, v);
+	r.consume(c.p - p);
+	return digits;
+}
+
+template <class Reader>
+bool read_integer(Reader &r, size_t width, unsigned int base, int separator, integer_value &v, std::false_type) {
+	reader_cursor<Reader> c = {r, width};
+	return parse_integer(c, base, separator, v);
+}
+
+//------------------------------------------------------------------------------
+// Name: read_float
+// Desc: reads a floating point field from the Reader. A reader which doesn't
+//       hold its input in memory is read into a buffer, which limits the field
+//       to 127 chars
+//------------------------------------------------------------------------------
+template <class Reader, class F>
+bool read_float(Reader &r, size_t width, F &value, std::true_type) {
+	size_t n;
+	const char *p = r.remaining(n);
+	span_cursor c = {p, p + std::min(n, width)};
+	const bool matched = match_float(c);
+	if (matched) {
+		parse_float(p, c.p, value);
+	}
+	r.consume(c.p - p);
+	return matched;
+}
+
+template <class Reader, class F>
+bool read_float(Reader &r, size_t width, F &value, std::false_type) {
+	char buf[128];
+	recording_cursor<Reader> c = {r, std::min(width, sizeof(buf)), buf, 0};
+	if (!match_float(c)) {
+		return false;
+	}
+
+	parse_float(buf, buf + c.length, value);
+	return true;
+}
+
+//------------------------------------------------------------------------------
+// Name: read_run
+// Desc: reads up to width chars for which pred is true into sink, returns how
+//       many were read
+//------------------------------------------------------------------------------
+template <class Reader, class Sink, class Pred>
+size_t read_run(Reader &r, size_t width, Sink &sink, Pred pred, std::true_type) {
+	size_t n;
+	const char *p   = r.remaining(n);
+	const char *end = p + std::min(n, width);
+	const char *q   = p;
+	while (q != end && pred(static_cast<unsigned char>(*q))) {
+		++q;
+	}
+
+	sink.put(p, q - p);
+	r.consume(q - p);
+	return q - p;
+}
+
+template <class Reader, class Sink, class Pred>
+size_t read_run(Reader &r, size_t width, Sink &sink, Pred pred, std::false_type) {
+	size_t count = 0;
+	for (; count < width; ++count) {
+		const int ch = r.peek();
+		if (ch == EOF || !pred(ch)) {
+			break;
+		}
+		sink.put(static_cast<char>(ch));
+		r.advance();
+	}
+	return count;
+}
+
+struct not_space {
+	bool operator()(int ch) const noexcept {
+		return !is_space(ch);
+	}
+};
+
+struct any_char {
+	bool operator()(int) const noexcept {
+		return true;
+	}
+};
+
+struct in_set {
+	bool operator()(int ch) const noexcept {
+		return (set[ch >> 6] >> (ch & 63)) & 1;
+	}
+
+	const uint64_t *set;
+};
+
+// NOTE(eteran): %s, %c and %[ read into a char *, a char array, which then limits
+//               the field to its size, or a std::string. Anything else is an error
+template <class T>
+struct char_sink {
+	static constexpr bool valid = false;
+
+	char_sink(T &) {
+	}
+
+	size_t limit(size_t width, bool) const noexcept {
+		return width;
+	}
+
+	void put(char) noexcept {
+	}
+
+	void put(const char *, size_t) noexcept {
+	}
+
+	void finish(bool) noexcept {
+	}
+};
+
+template <>
+struct char_sink<char *> {
+	static constexpr bool valid = true;
+
+	char_sink(char *p) : p_(p) {
+	}
+
+	size_t limit(size_t width, bool) const noexcept {
+		return width;
+	}
+
+	void put(char ch) noexcept {
+		*p_++ = ch;
+	}
+
+	void put(const char *s, size_t n) noexcept {
+		memcpy(p_, s, n);
+		p_ += n;
+	}
+
+	void finish(bool terminate) noexcept {
+		if (terminate) {
+			*p_ = '\0';
+		}
+	}
+
+	char *p_;
+};
+
+template <size_t N>
+struct char_sink<char[N]> : char_sink<char *> {
+	char_sink(char (&a)[N]) : char_sink<char *>(a) {
+	}
+
+	// leave room for the NUL, if there is one
+	size_t limit(size_t width, bool terminate) const noexcept {
+		return std::min(width, N - terminate);
+	}
+};
+
+template <>
+struct char_sink<std::string *> {
+	static constexpr bool valid = true;
+
+	char_sink(std::string *s) : s_(s) {
+		s_->clear();
+	}
+
+	size_t limit(size_t width, bool) const noexcept {
+		return width;
+	}
+
+	void put(char ch) {
+		s_->push_back(ch);
+	}
+
+	void put(const char *s, size_t n) {
+		s_->append(s, n);
+	}
+
+	void finish(bool) noexcept {
+	}
+
+	std::string *s_;
+};
+
+template <>
+struct char_sink<discard> {
+	static constexpr bool valid = true;
+
+	char_sink(discard) {
+	}
+
+	size_t limit(size_t width, bool) const noexcept {
+		return width;
+	}
+
+	void put(char) noexcept {
+	}
+
+	void put(const char *, size_t) noexcept {
+	}
+
+	void finish(bool) noexcept {
+	}
+};
+
+// the type an argument points to, when it may be written through
+template <class T>
+struct target {
+	typedef void type;
+	static constexpr bool writable = false;
+};
+
+template <class T>
+struct target<T *> {
+	typedef T type;
+	static constexpr bool writable = !std::is_const<T>::value;
+};
+
+template <class T>
+struct integer_target : std::integral_constant<bool, target<T>::writable && std::is_integral<typename target<T>::type>::value && !std::is_same<typename target<T>::type, bool>::value> {
+};
+
+template <>
+struct integer_target<discard> : std::true_type {
+};
+
+template <class T>
+struct float_target : std::integral_constant<bool, target<T>::writable && std::is_floating_point<typename target<T>::type>::value> {
+	typedef typename std::conditional<std::is_floating_point<typename target<T>::type>::value, typename target<T>::type, double>::type type;
+};
+
+template <>
+struct float_target<discard> : std::true_type {
+	typedef double type;
+};
+
+template <class T>
+struct pointer_target : std::integral_constant<bool, target<T>::writable && std::is_pointer<typename target<T>::type>::value> {
+};
+
+template <>
+struct pointer_target<discard> : std::true_type {
+};
+
+//------------------------------------------------------------------------------
+// Name: store_integer
+// Desc: stores v through p, saturating as strtol and strtoul do
+//------------------------------------------------------------------------------
+template <class T>
+void store_integer(T *p, const integer_value &v, typename std::enable_if<integer_target<T *>::value && std::is_signed<T>::value>::type * = 0) noexcept {
+	typedef typename std::make_unsigned<T>::type U;
+
+	const uintmax_t max = static_cast<U>(std::numeric_limits<T>::max()) + static_cast<uintmax_t>(v.negative);
+
+	if (v.overflow || v.magnitude > max) {
+		*p = v.negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+	} else if (v.negative && v.magnitude != 0) {
+		*p = static_cast<T>(-static_cast<T>(v.magnitude - 1) - 1);
+	} else {
+		*p = static_cast<T>(v.magnitude);
+	}
+}
+
+template <class T>
+void store_integer(T *p, const integer_value &v, typename std::enable_if<integer_target<T *>::value && std::is_unsigned<T>::value>::type * = 0) noexcept {
+	if (v.overflow || v.magnitude > std::numeric_limits<T>::max()) {
+		*p = std::numeric_limits<T>::max();
+	} else {
+		// NOTE(eteran): like strtoul, a negative number wraps around
+		*p = static_cast<T>(v.negative ? 0 - v.magnitude : v.magnitude);
+	}
+}
+
+template <class T>
+void store_integer(const T &, const integer_value &) noexcept {
+}
+
+template <class T>
+void store_pointer(T *p, const integer_value &v, typename std::enable_if<pointer_target<T *>::value>::type * = 0) noexcept {
+	*p = reinterpret_cast<T>(static_cast<uintptr_t>(v.magnitude));
+}
+
+template <class T>
+void store_pointer(const T &, const integer_value &) noexcept {
+}
+
+template <class T>
+void store_float(T *p, T value, typename std::enable_if<float_target<T *>::value>::type * = 0) noexcept {
+	*p = value;
+}
+
+template <class T, class F>
+void store_float(const T &, F) noexcept {
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_integer
+// Desc: reads an integer in the given base, 0 meaning any of them as for %i
+//------------------------------------------------------------------------------
+template <class Reader, class T>
+scan_status scan_integer(Reader &r, const ScanSpec &spec, unsigned int base, T &arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	if (!integer_target<T>::value) {
+		return raise<scan_status>(err, format_errc::non_integer_argument);
+	}
+
+	skip_space(r);
+	if (r.peek() == EOF) {
+		return scan_status::input_end;
+	}
+
+	const int separator = spec.grouping ? get_grouping(r, 0).separator : EOF;
+
+	integer_value v;
+	if (!read_integer(r, spec.width, base, separator, v, std::integral_constant<bool, has_remaining<Reader>::value>())) {
+		return scan_status::mismatch;
+	}
+
+	store_integer(arg, v);
+	return scan_status::matched;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_pointer
+// Desc: reads a pointer, as printed by %p
+//------------------------------------------------------------------------------
+template <class Reader, class T>
+scan_status scan_pointer(Reader &r, const ScanSpec &spec, T &arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	if (!pointer_target<T>::value) {
+		return raise<scan_status>(err, format_errc::non_pointer_argument);
+	}
+
+	skip_space(r);
+	if (r.peek() == EOF) {
+		return scan_status::input_end;
+	}
+
+	integer_value v;
+	if (!read_integer(r, spec.width, 16, EOF, v, std::integral_constant<bool, has_remaining<Reader>::value>())) {
+		return scan_status::mismatch;
+	}
+
+	store_pointer(arg, v);
+	return scan_status::matched;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_float
+// Desc: reads a floating point number, of the precision of the argument
+//------------------------------------------------------------------------------
+template <class Reader, class T>
+scan_status scan_float(Reader &r, const ScanSpec &spec, T &arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	if (!float_target<T>::value) {
+		return raise<scan_status>(err, format_errc::non_float_argument);
+	}
+
+	skip_space(r);
+	if (r.peek() == EOF) {
+		return scan_status::input_end;
+	}
+
+	typename float_target<T>::type value;
+	if (!read_float(r, spec.width, value, std::integral_constant<bool, has_remaining<Reader>::value>())) {
+		return scan_status::mismatch;
+	}
+
+	store_float(arg, value);
+	return scan_status::matched;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_chars
+// Desc: handles %s, %c and %[, which differ in which chars they accept, whether
+//       they skip leading white space and whether the result is NUL terminated
+//------------------------------------------------------------------------------
+template <class Reader, class T>
+scan_status scan_chars(Reader &r, const ScanSpec &spec, T &arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	if (!char_sink<T>::valid) {
+		return raise<scan_status>(err, format_errc::non_string_argument);
+	}
+
+	const std::integral_constant<bool, has_remaining<Reader>::value> tag;
+
+	if (spec.conversion == 's') {
+		skip_space(r);
+	}
+
+	if (r.peek() == EOF) {
+		return scan_status::input_end;
+	}
+
+	char_sink<T> sink(arg);
+
+	switch (spec.conversion) {
+	case 'c': {
+		// NOTE(eteran): width chars, 1 by default, without a NUL. Like glibc, fewer
+		//               are accepted at the end of the input
+		const size_t width = sink.limit((spec.width == SIZE_MAX) ? 1 : spec.width, false);
+		read_run(r, width, sink, any_char(), tag);
+		return scan_status::matched;
+	}
+	case 's':
+		if (read_run(r, sink.limit(spec.width, true), sink, not_space(), tag) == 0) {
+			return scan_status::mismatch;
+		}
+		break;
+	default:
+		if (read_run(r, sink.limit(spec.width, true), sink, in_set{spec.set}, tag) == 0) {
+			return scan_status::mismatch;
+		}
+		break;
+	}
+
+	sink.finish(true);
+	return scan_status::matched;
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_argument
+// Desc: reads a single conversion from the Reader into arg, which is discard for
+//       suppressed conversions. Errors with the argument are reported in err
+//------------------------------------------------------------------------------
+template <class Reader, class T>
+scan_status scan_argument(Reader &r, const ScanSpec &spec, T &arg, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	switch (spec.conversion) {
+	case 'd':
+	case 'u':
+		return scan_integer(r, spec, 10, arg, err);
+	case 'i':
+		return scan_integer(r, spec, 0, arg, err);
+	case 'o':
+		return scan_integer(r, spec, 8, arg, err);
+	case 'x':
+	case 'X':
+		return scan_integer(r, spec, 16, arg, err);
+#ifdef CXX11_PRINTF_EXTENSIONS
+	case 'b': // extension, BINARY mode
+		return scan_integer(r, spec, 2, arg, err);
+#endif
+	case 'p':
+		return scan_pointer(r, spec, arg, err);
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'F':
+	case 'a':
+	case 'A':
+	case 'g':
+	case 'G':
+		return scan_float(r, spec, arg, err);
+	case 'n': {
+		if (!integer_target<T>::value) {
+			return raise<scan_status>(err, format_errc::non_integer_argument);
+		}
+
+		const integer_value v = {r.consumed, false, false};
+		store_integer(arg, v);
+		return scan_status::matched;
+	}
+	default:
+		return scan_chars(r, spec, arg, err);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_format
+// Desc: matches the format against the input until the next conversion which
+//       needs an argument, performing any suppressed conversions on the way.
+//       Returns true if one was found, and its details are in spec. Otherwise,
+//       status says why not, or err if the format is bad
+//------------------------------------------------------------------------------
+template <class Reader>
+bool scan_format(Reader &r, const char *&format, ScanSpec &spec, scan_status &status, format_errc &err) CXX11_PRINTF_NOEXCEPT {
+
+	status = scan_status::matched;
+
+	while (true) {
+		const char ch = *format;
+		if (ch == '\0') {
+			return false;
+		}
+
+		// white space in the format matches any amount of it in the input
+		if (is_space(static_cast<unsigned char>(ch))) {
+			do {
+				++format;
+			} while (is_space(static_cast<unsigned char>(*format)));
+			skip_space(r);
+			continue;
+		}
+
+		++format;
+		if (ch != '%' || *format == '%') {
+			if (ch == '%') {
+				++format;
+				skip_space(r);
+			}
+
+			const int in = r.peek();
+			if (in == EOF) {
+				status = scan_status::input_end;
+				return false;
+			}
+
+			if (in != static_cast<unsigned char>(ch)) {
+				status = scan_status::mismatch;
+				return false;
+			}
+
+			r.advance();
+			continue;
+		}
+
+		spec.suppress = false;
+		spec.grouping = false;
+		for (;; ++format) {
+			if (*format == '*') {
+				spec.suppress = true;
+			} else if (*format == '\'') {
+				spec.grouping = true;
+			} else {
+				break;
+			}
+		}
+
+		spec.width = SIZE_MAX;
+		if (*format >= '0' && *format <= '9') {
+			const long int width = parse_long(format);
+			if (width <= 0) {
+				err = format_errc::bad_format;
+				return false;
+			}
+			spec.width = width;
+		}
+
+		parse_modifier(format);
+
+		spec.conversion = *format++;
+		switch (spec.conversion) {
+		case 'd':
+		case 'i':
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+#ifdef CXX11_PRINTF_EXTENSIONS
+		case 'b':
+#endif
+		case 'p':
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'a':
+		case 'A':
+		case 'g':
+		case 'G':
+		case 's':
+		case 'c':
+		case 'n':
+			break;
+		case '[':
+			if (!parse_scanset(format, spec.set)) {
+				err = format_errc::bad_format;
+				return false;
+			}
+			break;
+		default:
+			err = format_errc::bad_format;
+			return false;
+		}
+
+		if (!spec.suppress) {
+			return true;
+		}
+
+		discard nothing;
+		status = scan_argument(r, spec, nothing, err);
+		if (status != scan_status::matched || err != format_errc::none) {
+			return false;
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Name: scan_fail
+// Desc: reports an error in the format or with an argument, scanning can not
+//       continue
+//------------------------------------------------------------------------------
+template <class Reader>
+int scan_fail(Reader &r, format_errc code) CXX11_PRINTF_NOEXCEPT {
+#ifdef CXX11_PRINTF_NO_EXCEPTIONS
+	set_error(r, code, 0);
+	return -1;
+#else
+	(void)r;
+	throw format_error(code);
+#endif
+}
+
+// NOTE(eteran): as with scanf, an input failure before anything was assigned is EOF
+inline int scan_result(scan_status status, int assigned) noexcept {
+	return (status == scan_status::input_end && assigned == 0) ? EOF : assigned;
+}
+
+//------------------------------------------------------------------------------
+// Name: scanf_sequential
+// Desc: 0 argument version of scanf_sequential. Fails on any conversion which
+//       needs an argument, as there is nothing left to read into
+//------------------------------------------------------------------------------
+template <class Reader>
+int scanf_sequential(Reader &r, const char *format, int assigned) CXX11_PRINTF_NOEXCEPT {
+
+	ScanSpec spec;
+	scan_status status;
+	format_errc err = format_errc::none;
+
+	if (scan_format(r, format, spec, status, err)) {
+		return scan_fail(r, format_errc::bad_format);
+	}
+
+	if (err != format_errc::none) {
+		return scan_fail(r, err);
+	}
+
+	return scan_result(status, assigned);
+}
+
+//------------------------------------------------------------------------------
+// Name: scanf_sequential
+// Desc: reads the next conversion into arg, then recursively continues with the
+//       rest of the format. Returns the number of arguments assigned
+//------------------------------------------------------------------------------
+template <class Reader, class T, class... Ts>
+int scanf_sequential(Reader &r, const char *format, int assigned, T &arg, Ts &... ts) CXX11_PRINTF_NOEXCEPT {
+
+	ScanSpec spec;
+	scan_status status;
+	format_errc err = format_errc::none;
+
+	if (!scan_format(r, format, spec, status, err)) {
+		if (err != format_errc::none) {
+			return scan_fail(r, err);
+		}
+		return scan_result(status, assigned);
+	}
+
+	status = scan_argument(r, spec, arg, err);
+	if (err != format_errc::none) {
+		return scan_fail(r, err);
+	}
+
+	if (status != scan_status::matched) {
+		return scan_result(status, assigned);
+	}
+
+	// %n is not counted as an assignment
+	return scanf_sequential(r, format, assigned + (spec.conversion != 'n'), ts...);
+}
+
+}
+
+//------------------------------------------------------------------------------
+// Name: Scanf
+// Desc: reads the input of the Reader according to format, storing the results
+//       through the arguments, which are pointers, char arrays or std::strings
+//       as appropriate. Returns the number of arguments assigned, or EOF if the
+//       input ended before any were
+//------------------------------------------------------------------------------
+template <class Reader, class... Ts>
+int Scanf(Reader &r, const char *format, Ts &&... ts) CXX11_PRINTF_NOEXCEPT {
+	assert(format);
+	return detail::scanf_sequential(r, format, 0, ts...);
+}
+
+//------------------------------------------------------------------------------
+// Name: sscanf
+// Desc: implementation of what sscanf compatible interface
+//------------------------------------------------------------------------------
+template <class... Ts>
+int sscanf(const char *str, const char *format, Ts &&... ts) CXX11_PRINTF_NOEXCEPT {
+	buffer_reader r(str);
+	return Scanf(r, format, ts...);
+}
+
+template <class... Ts>
+int sscanf(const std::string &str, const char *format, Ts &&... ts) CXX11_PRINTF_NOEXCEPT {
+	buffer_reader r(str.data(), str.size());
+	return Scanf(r, format, ts...);
+}
+
+template <class... Ts>
+int sscanf(std::istream &is, const char *format, Ts &&... ts) CXX11_PRINTF_NOEXCEPT {
+	istream_reader r(is);
+	return Scanf(r, format, ts...);
+}
+
+//------------------------------------------------------------------------------
+// Name: scanf
+// Desc: implementation of what scanf compatible interface
+//------------------------------------------------------------------------------
+template <class... Ts>
+int scanf(const char *format, Ts &&... ts) CXX11_PRINTF_NOEXCEPT {
+	stdio_reader r(stdin);
+	return Scanf(r, format, ts...);
+}
+}
+
+#endif
@@ -1,8 +1,17 @@
 
 #include "Printf.h"
+#include "Scanf.h"
 
 #include <chrono>
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 template <class R, int Count, class F>
 R time_code(F func) {
@@ -20,6 +29,71 @@ R time_code(F func) {
 	return std::chrono::duration_cast<R>(dur);
 }
 
+// a buffer_writer which doesn't offer reserve/commit, so every conversion is
+// formatted into a temporary and then copied
+struct copying_writer {
+
+	copying_writer(char *buffer, size_t size) : ctx_(buffer, size) {
+	}
+
+	void write(char ch) noexcept {
+		ctx_.write(ch);
+		++written;
+	}
+
+	void write(const char *p, size_t n) {
+		ctx_.write(p, n);
+		written += n;
+	}
+
+	void done() noexcept {
+		ctx_.done();
+	}
+
+	cxx11::buffer_writer ctx_;
+	size_t written = 0;
+};
+
+// counts the lines written by print_lines which did not come out whole and in order
+template <int Threads>
+int damaged_lines(FILE *file) {
+
+	int next[Threads] = {};
+	int damaged       = 0;
+	char line[256];
+
+	rewind(file);
+	while (fgets(line, sizeof(line), file)) {
+		int t;
+		int i;
+		char rest[128];
+		if (sscanf(line, "thread %d line %d %127[^\n]", &t, &i, rest) != 3 || t < 0 || t >= Threads || i != next[t]++ || strcmp(rest, "the quick brown fox jumps over the lazy dog") != 0) {
+			++damaged;
+		}
+	}
+
+	return damaged;
+}
+
+// has Threads threads each print Lines lines to file at the same time
+template <class Writer, int Threads, int Lines>
+void print_lines(FILE *file) {
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < Threads; ++t) {
+		threads.emplace_back([file, t]() {
+			for (int i = 0; i < Lines; ++i) {
+				Writer ctx(file);
+				cxx11::Printf(ctx, "thread %d line %d %s\n", t, i, "the quick brown fox jumps over the lazy dog");
+			}
+		});
+	}
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
 #ifdef CXX11_PRINTF_EXTENSIONS
 class Test {};
 
@@ -36,6 +110,20 @@ int main() {
 	cxx11::printf("hello %*s, %c, %d, %08x %p %016u %02x %016o\n", 10, "world", 0x41, -123, 0x1234, static_cast<void *>(&Foo), -4, -1, 1234);
 	       printf("hello %*s, %c, %d, %08x %p %016u %02x %016o\n", 10, "world", 0x41, -123, 0x1234, static_cast<void *>(&Foo), -4, -1, 1234);
 
+	// a negative width from an argument is the '-' flag, in either mode
+	cxx11::printf("[%0*d] [%-*s]\n", -4, 1, -4, "ab");
+	       printf("[%0*d] [%-*s]\n", -4, 1, -4, "ab");
+	cxx11::printf("[%1$*2$d]\n", 1, -4);
+
+#ifdef CXX11_PRINTF_HAS_CONSTEXPR
+	{
+		// generated at compile time
+		constexpr auto banner = cxx11::format_array<32>("[%-8s|%+06d|%#x]", "const", 42, 255u);
+		static_assert(banner[1] == 'c' && banner[10] == '+', "");
+		cxx11::printf("%s\n", banner.data());
+	}
+#endif
+
 	typedef std::chrono::microseconds ms;
 
 	constexpr int count = 1000000;
@@ -60,6 +148,322 @@ int main() {
 		
 		cxx11::printf("%032b\n", 5ul);
 		cxx11::printf("%032b\n", 1234ul);
+
+		// fixed point, 123456.789 with a scale of 1e-8
+		cxx11::printf("%'.2/8k\n", 12345678900000ll);
+
+		// unsigned arguments are never read as signed, 184467440737095516.15
+		cxx11::printf("%/2k\n", 18446744073709551615ull);
+	}
+#endif
+
+	{
+		// a format whose output size is known at compile time needs no bounds checks
+		auto time10 = time_code<ms, count>([&Foo]() {
+			char buf[128];
+			cxx11::sprintf(buf, sizeof(buf), "hello %10.5s, %c, %d, %08x %p %016u %02x %016o\n", "world", 0x41, -123, 0x1234, static_cast<void *>(&Foo), -4, -1, 1234);
+		});
+
+		auto time11 = time_code<ms, count>([&Foo]() {
+			std::array<char, cxx11::format_bound<const char *, int, int, int, void *, int, int, int>("hello %10.5s, %c, %d, %08x %p %016u %02x %016o\n") + 1> buf;
+			CXX11_SPRINTF(buf, "hello %10.5s, %c, %d, %08x %p %016u %02x %016o\n", "world", 0x41, -123, 0x1234, static_cast<void *>(&Foo), -4, -1, 1234);
+		});
+
+		std::cerr << "buffer_writer Took:    " << time10.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "unchecked_writer Took: " << time11.count() << " \xC2\xB5s to execute." << std::endl;
+	}
+
+	{
+		// wide conversions are bounded by the UTF-8 they write, not the chars they read
+		static_assert(cxx11::format_bound<char32_t>("%lc") == 4, "");
+		static_assert(cxx11::format_bound<const wchar_t *>("%.2ls") == 2, "");
+#ifdef CXX11_PRINTF_HAS_CONSTEXPR
+		// and a precision never splits a character, even when nothing is transcoded
+		static_assert(cxx11::format_array<8>("[%.2s]", "\xe2\x82\xac")[1] == ']', "");
+		static_assert(cxx11::format_array<8>(u"[%.1s]", u"\U0001f600")[1] == u']', "");
+#endif
+
+		std::array<char, 2> c;
+		std::array<char, 3> s;
+		const int n1 = CXX11_SPRINTF(c, "%lc", static_cast<char32_t>(0x1f600));
+		const int n2 = CXX11_SPRINTF(s, "%.2ls", L"\u20ac\u20ac");
+		cxx11::printf("%%lc wrote %d, %%.2ls wrote %d [%s]\n", n1, n2, s.data());
+	}
+
+	{
+		// integer heavy formats, written directly into the destination or copied
+		int i = 0;
+
+		auto time15 = time_code<ms, count>([&i]() {
+			char buf[128];
+			cxx11::buffer_writer ctx(buf, sizeof(buf));
+			cxx11::Printf(ctx, "%d %u %08x %-10lld %+d %#o\n", i, i * 7u, i, i * 1000003ll, -i, i);
+			++i;
+		});
+
+		i = 0;
+		auto time16 = time_code<ms, count>([&i]() {
+			char buf[128];
+			copying_writer ctx(buf, sizeof(buf));
+			cxx11::Printf(ctx, "%d %u %08x %-10lld %+d %#o\n", i, i * 7u, i, i * 1000003ll, -i, i);
+			++i;
+		});
+
+		std::cerr << "reserve/commit Took: " << time15.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "copy Took:           " << time16.count() << " \xC2\xB5s to execute." << std::endl;
+	}
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+	{
+		// shortest round trip doubles
+		double value = 0.1;
+
+		auto time12 = time_code<ms, count>([&value]() {
+			char buf[32];
+			cxx11::sprintf(buf, sizeof(buf), "%r", value);
+			value += 1.37;
+		});
+
+		value = 0.1;
+		auto time13 = time_code<ms, count>([&value]() {
+			char buf[32];
+			snprintf(buf, sizeof(buf), "%.17g", value);
+			value += 1.37;
+		});
+
+		std::cerr << "%r Took:       " << time12.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "%.17g Took:    " << time13.count() << " \xC2\xB5s to execute." << std::endl;
+
+#ifdef __cpp_lib_to_chars
+		value = 0.1;
+		auto time14 = time_code<ms, count>([&value]() {
+			char buf[32];
+			*std::to_chars(buf, buf + sizeof(buf) - 1, value).ptr = '\0';
+			value += 1.37;
+		});
+
+		std::cerr << "to_chars Took: " << time14.count() << " \xC2\xB5s to execute." << std::endl;
+#endif
+	}
+#endif
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+	{
+		// timestamps, as they would appear at the start of each line of a log
+		const auto start = std::chrono::system_clock::now();
+		int i = 0;
+
+		auto time6 = time_code<ms, count>([&start, &i]() {
+			char buf[128];
+			cxx11::sprintf(buf, sizeof(buf), "%#T", start + std::chrono::microseconds(++i * 10));
+		});
+
+		i = 0;
+		auto time7 = time_code<ms, count>([&start, &i]() {
+			char buf[128];
+			const auto now    = start + std::chrono::microseconds(++i * 10);
+			const time_t t    = std::chrono::system_clock::to_time_t(now);
+			const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+			struct tm tm;
+			localtime_r(&t, &tm);
+			size_t n = strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+			snprintf(buf + n, sizeof(buf) - n, ".%03d", static_cast<int>(millis));
+		});
+
+		std::cerr << "%T Took:       " << time6.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "strftime Took: " << time7.count() << " \xC2\xB5s to execute." << std::endl;
+	}
+#endif
+
+#ifdef CXX11_PRINTF_EXTENSIONS
+	{
+		// hex dumps of a 4KiB packet
+		static unsigned char packet[4096];
+		for (size_t i = 0; i < sizeof(packet); ++i) {
+			packet[i] = static_cast<unsigned char>(i * 31);
+		}
+
+		static char buf[sizeof(packet) * 2 + 1];
+
+		auto time8 = time_code<ms, 1000>([]() {
+			cxx11::sprintf(buf, sizeof(buf), "%y", cxx11::bytes(packet, sizeof(packet)));
+		});
+
+		auto time9 = time_code<ms, 1000>([]() {
+			for (size_t i = 0; i < sizeof(packet); ++i) {
+				cxx11::sprintf(buf + i * 2, 3, "%02x", packet[i]);
+			}
+		});
+
+		std::cerr << "%y Took:       " << time8.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "%02x Took:     " << time9.count() << " \xC2\xB5s to execute." << std::endl;
+	}
+#endif
+
+	{
+		// many short requests, each formatting a handful of strings which are all
+		// discarded when the request is done
+		constexpr int requests = 100000;
+		constexpr int strings  = 16;
+
+		cxx11::arena arena;
+		size_t total1 = 0;
+		size_t total2 = 0;
+
+		auto time20 = time_code<ms, requests>([&arena, &total1]() {
+			static long long id = 0;
+			++id;
+
+			arena.reset();
+			for (int i = 0; i < strings; ++i) {
+				cxx11::arena_writer ctx(arena);
+				cxx11::Printf(ctx, "/api/v1/items/%lld?page=%d&user=%s", id, i, "someone@example.com");
+				total1 += ctx.size();
+			}
+		});
+
+		auto time21 = time_code<ms, requests>([&total2]() {
+			static long long id = 0;
+			++id;
+
+			std::string s[strings];
+			for (int i = 0; i < strings; ++i) {
+				cxx11::container_writer<std::string> ctx(s[i]);
+				cxx11::Printf(ctx, "/api/v1/items/%lld?page=%d&user=%s", id, i, "someone@example.com");
+				total2 += s[i].size();
+			}
+		});
+
+		std::cerr << "arena_writer Took:     " << time20.count() << " \xC2\xB5s to execute, " << total1 << " bytes." << std::endl;
+		std::cerr << "container_writer Took: " << time21.count() << " \xC2\xB5s to execute, " << total2 << " bytes." << std::endl;
+	}
+
+	{
+		// UTF-16 output, formatted directly or formatted as UTF-8 and then transcoded
+		int i = 0;
+
+		auto time22 = time_code<ms, count>([&i]() {
+			char16_t buf[128];
+			cxx11::basic_buffer_writer<char16_t> ctx(buf, 128);
+			cxx11::Printf(ctx, u"%-12ls %5d %08x %s\n", "caf\xC3\xA9", i, i, u"über");
+			++i;
+		});
+
+		i = 0;
+		auto time23 = time_code<ms, count>([&i]() {
+			char utf8[128];
+			cxx11::sprintf(utf8, sizeof(utf8), "%-12s %5d %08x %s\n", "caf\xC3\xA9", i, i, "\xC3\xBC" "ber");
+
+			char16_t buf[128];
+			cxx11::basic_buffer_writer<char16_t> ctx(buf, 128);
+			cxx11::Printf(ctx, u"%ls", static_cast<const char *>(utf8));
+			++i;
+		});
+
+		std::cerr << "char16_t Took:        " << time22.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "UTF-8 + convert Took: " << time23.count() << " \xC2\xB5s to execute." << std::endl;
 	}
+
+	{
+		// parsing log lines, as when replaying a log
+		static char lines[1000][128];
+		for (int i = 0; i < 1000; ++i) {
+			cxx11::sprintf(lines[i], sizeof(lines[i]), "2024-03-17 12:%02d:%02d.%03d GET /api/v1/items/%d 200 %d 0.%04d", i % 60, (i * 7) % 60, i, i * 7919, 1000 + i * 3, i);
+		}
+
+		int i = 0;
+		long total1 = 0;
+		long total2 = 0;
+
+		auto time24 = time_code<ms, count>([&i, &total1]() {
+			int year, month, day, hour, minute, second, millis, status, size;
+			double latency;
+			char method[8];
+			char path[64];
+			cxx11::sscanf(lines[i++ % 1000], "%d-%d-%d %d:%d:%d.%d %s %s %d %d %lf", &year, &month, &day, &hour, &minute, &second, &millis, method, path, &status, &size, &latency);
+			total1 += size;
+		});
+
+		i = 0;
+		auto time25 = time_code<ms, count>([&i, &total2]() {
+			int year, month, day, hour, minute, second, millis, status, size;
+			double latency;
+			char method[8];
+			char path[64];
+			sscanf(lines[i++ % 1000], "%d-%d-%d %d:%d:%d.%d %7s %63s %d %d %lf", &year, &month, &day, &hour, &minute, &second, &millis, method, path, &status, &size, &latency);
+			total2 += size;
+		});
+
+		std::cerr << "cxx11::sscanf Took: " << time24.count() << " \xC2\xB5s to execute, total " << total1 << "." << std::endl;
+		std::cerr << "sscanf Took:        " << time25.count() << " \xC2\xB5s to execute, total " << total2 << "." << std::endl;
+	}
+
+	{
+		// concurrent line output, each line should come out whole
+		constexpr int threads = 8;
+		constexpr int lines   = 50000;
+
+		FILE *file1 = tmpfile();
+		FILE *file2 = tmpfile();
+
+		auto time18 = time_code<ms, 1>([file1]() {
+			print_lines<cxx11::atomic_writer, threads, lines>(file1);
+		});
+
+		auto time19 = time_code<ms, 1>([file2]() {
+			print_lines<cxx11::stdio_writer, threads, lines>(file2);
+		});
+
+		std::cerr << "atomic_writer Took: " << time18.count() << " \xC2\xB5s to execute, " << damaged_lines<threads>(file1) << " damaged lines." << std::endl;
+		std::cerr << "stdio_writer Took:  " << time19.count() << " \xC2\xB5s to execute, " << damaged_lines<threads>(file2) << " damaged lines." << std::endl;
+
+		fclose(file1);
+		fclose(file2);
+	}
+
+#ifdef __linux__
+	{
+		// large sequential file output
+		constexpr int lines = 2000000;
+
+		auto time3 = time_code<ms, 1>([&Foo]() {
+			FILE *file = fopen("cxx11_printf_stdio.txt", "wb");
+			cxx11::stdio_writer ctx(file);
+			for (int i = 0; i < lines; ++i) {
+				cxx11::Printf(ctx, "%d, %08x %p %s\n", i, i, static_cast<void *>(&Foo), "hello world");
+			}
+			fclose(file);
+		});
+
+		auto time4 = time_code<ms, 1>([&Foo]() {
+			FILE *file = fopen("cxx11_printf_fwrite.txt", "wb");
+			for (int i = 0; i < lines; ++i) {
+				char buf[128];
+				int n = cxx11::sprintf(buf, sizeof(buf), "%d, %08x %p %s\n", i, i, static_cast<void *>(&Foo), "hello world");
+				fwrite(buf, 1, n, file);
+			}
+			fclose(file);
+		});
+
+		auto time5 = time_code<ms, 1>([&Foo]() {
+			cxx11::mmap_writer ctx("cxx11_printf_mmap.txt");
+			for (int i = 0; i < lines; ++i) {
+				cxx11::Printf(ctx, "%d, %08x %p %s\n", i, i, static_cast<void *>(&Foo), "hello world");
+			}
+			ctx.close();
+		});
+
+		remove("cxx11_printf_stdio.txt");
+		remove("cxx11_printf_fwrite.txt");
+		remove("cxx11_printf_mmap.txt");
+
+		std::cerr << "stdio_writer Took: " << time3.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "fwrite Took:       " << time4.count() << " \xC2\xB5s to execute." << std::endl;
+		std::cerr << "mmap_writer Took:  " << time5.count() << " \xC2\xB5s to execute." << std::endl;
+	}
+#endif
+
+#ifdef CXX11_PRINTF_INSTRUMENT
+	std::cerr << cxx11::instrument::dump_text();
 #endif
 }
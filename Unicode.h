@@ -0,0 +1,200 @@
+
+#ifndef UNICODE_20160922_H_
+#define UNICODE_20160922_H_
+
+// NOTE(eteran): this header converts between the Unicode encodings, for output
+//               to contexts which aren't char based. The encoding of a string
+//               is implied by the size of its character type: 1 byte is UTF-8,
+//               2 bytes is UTF-16 and 4 bytes is UTF-32. Invalid input decodes
+//               as U+FFFD rather than failing
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// NOTE(eteran): normally defined by Printf.h
+#ifndef CXX11_PRINTF_CONSTEXPR
+#define CXX11_PRINTF_CONSTEXPR
+#define CXX11_PRINTF_CONSTANT_EVALUATED() false
+#endif
+
+namespace cxx11 {
+namespace detail {
+namespace unicode {
+
+constexpr char32_t replacement = 0xfffd;
+
+template <class Ch>
+using encoding = std::integral_constant<size_t, sizeof(Ch)>;
+
+constexpr bool is_valid(char32_t cp) noexcept {
+	return cp <= 0x10ffff && (cp < 0xd800 || cp > 0xdfff);
+}
+
+//------------------------------------------------------------------------------
+// Name: decode
+// Desc: decodes one code point from [p, end), advancing p past it
+//------------------------------------------------------------------------------
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR char32_t decode(const Ch *&p, const Ch *end, std::integral_constant<size_t, 1>) noexcept {
+
+	const unsigned char lead = static_cast<unsigned char>(*p++);
+	if (lead < 0x80) {
+		return lead;
+	}
+
+	size_t   extra = 0;
+	char32_t cp    = 0;
+	char32_t min   = 0;
+
+	if (lead >= 0xc2 && lead <= 0xdf) {
+		extra = 1;
+		cp    = lead & 0x1f;
+		min   = 0x80;
+	} else if (lead >= 0xe0 && lead <= 0xef) {
+		extra = 2;
+		cp    = lead & 0x0f;
+		min   = 0x800;
+	} else if (lead >= 0xf0 && lead <= 0xf4) {
+		extra = 3;
+		cp    = lead & 0x07;
+		min   = 0x10000;
+	} else {
+		return replacement;
+	}
+
+	// NOTE(eteran): a truncated sequence only consumes its valid prefix
+	for (size_t i = 0; i < extra; ++i) {
+		if (p == end || (static_cast<unsigned char>(*p) & 0xc0) != 0x80) {
+			return replacement;
+		}
+		cp = (cp << 6) | (static_cast<unsigned char>(*p++) & 0x3f);
+	}
+
+	return (cp >= min && is_valid(cp)) ? cp : replacement;
+}
+
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR char32_t decode(const Ch *&p, const Ch *end, std::integral_constant<size_t, 2>) noexcept {
+
+	const char32_t unit = static_cast<uint16_t>(*p++);
+	if (unit < 0xd800 || unit > 0xdfff) {
+		return unit;
+	}
+
+	if (unit <= 0xdbff && p != end) {
+		const char32_t low = static_cast<uint16_t>(*p);
+		if (low >= 0xdc00 && low <= 0xdfff) {
+			++p;
+			return 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+		}
+	}
+
+	return replacement;
+}
+
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR char32_t decode(const Ch *&p, const Ch *end, std::integral_constant<size_t, 4>) noexcept {
+	(void)end;
+	const char32_t cp = static_cast<uint32_t>(*p++);
+	return is_valid(cp) ? cp : replacement;
+}
+
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR char32_t decode(const Ch *&p, const Ch *end) noexcept {
+	return decode(p, end, encoding<Ch>());
+}
+
+//------------------------------------------------------------------------------
+// Name: truncate
+// Desc: returns n, or less if the first n units of [p, end) would end part way
+//       through a code point, in which case they end before that code point
+//------------------------------------------------------------------------------
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR size_t truncate(const Ch *p, const Ch *end, size_t n) noexcept {
+
+	// NOTE(eteran): only the last few units can begin a code point which doesn't fit
+	const size_t longest = (sizeof(Ch) == 1) ? 4 : (sizeof(Ch) == 2) ? 2 : 1;
+	for (size_t i = 1; i < longest && i <= n; ++i) {
+		const Ch *next = p + n - i;
+		decode(next, end);
+		if (next > p + n) {
+			return n - i;
+		}
+	}
+
+	return n;
+}
+
+//------------------------------------------------------------------------------
+// Name: encode
+// Desc: writes the valid code point cp to out, returns the number of units
+//       written, at most 4
+//------------------------------------------------------------------------------
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR size_t encode(char32_t cp, Ch *out, std::integral_constant<size_t, 1>) noexcept {
+	if (cp < 0x80) {
+		out[0] = static_cast<Ch>(cp);
+		return 1;
+	}
+
+	if (cp < 0x800) {
+		out[0] = static_cast<Ch>(0xc0 | (cp >> 6));
+		out[1] = static_cast<Ch>(0x80 | (cp & 0x3f));
+		return 2;
+	}
+
+	if (cp < 0x10000) {
+		out[0] = static_cast<Ch>(0xe0 | (cp >> 12));
+		out[1] = static_cast<Ch>(0x80 | ((cp >> 6) & 0x3f));
+		out[2] = static_cast<Ch>(0x80 | (cp & 0x3f));
+		return 3;
+	}
+
+	out[0] = static_cast<Ch>(0xf0 | (cp >> 18));
+	out[1] = static_cast<Ch>(0x80 | ((cp >> 12) & 0x3f));
+	out[2] = static_cast<Ch>(0x80 | ((cp >> 6) & 0x3f));
+	out[3] = static_cast<Ch>(0x80 | (cp & 0x3f));
+	return 4;
+}
+
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR size_t encode(char32_t cp, Ch *out, std::integral_constant<size_t, 2>) noexcept {
+	if (cp < 0x10000) {
+		out[0] = static_cast<Ch>(cp);
+		return 1;
+	}
+
+	cp -= 0x10000;
+	out[0] = static_cast<Ch>(0xd800 + (cp >> 10));
+	out[1] = static_cast<Ch>(0xdc00 + (cp & 0x3ff));
+	return 2;
+}
+
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR size_t encode(char32_t cp, Ch *out, std::integral_constant<size_t, 4>) noexcept {
+	out[0] = static_cast<Ch>(cp);
+	return 1;
+}
+
+template <class Ch>
+CXX11_PRINTF_CONSTEXPR size_t encode(char32_t cp, Ch *out) noexcept {
+	return encode(cp, out, encoding<Ch>());
+}
+
+//------------------------------------------------------------------------------
+// Name: encoded_length
+// Desc: returns the number of units encode will write for the valid code point cp
+//------------------------------------------------------------------------------
+template <class Ch>
+constexpr size_t encoded_length(char32_t cp) noexcept {
+	return (sizeof(Ch) == 1) ? (cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4) :
+		   (sizeof(Ch) == 2) ? (cp < 0x10000 ? 1 : 2) :
+		   1;
+}
+
+}
+}
+}
+
+#endif